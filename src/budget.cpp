@@ -0,0 +1,49 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "budget.h"
+
+namespace castor {
+
+void Budget::clear() {
+    countdown_ = CHECK_INTERVAL;
+    deadline_ = std::numeric_limits<unsigned long long>::max();
+    backtracks_ = 0;
+    maxBacktracks_ = std::numeric_limits<unsigned long>::max();
+    triples_ = 0;
+    maxTriples_ = std::numeric_limits<unsigned long>::max();
+    cancelled_.store(false, std::memory_order_relaxed);
+}
+
+void Budget::check() {
+    countdown_ = CHECK_INTERVAL;
+    if(cancelled_.load(std::memory_order_relaxed))
+        exceeded("cancelled");
+    if(deadline_ != std::numeric_limits<unsigned long long>::max() &&
+       monotonicTime() > deadline_)
+        exceeded("time limit reached");
+}
+
+void Budget::exceeded(const char* reason) {
+    // the limit stays exceeded: make the next charge check again
+    countdown_ = 1;
+    BudgetExceeded e;
+    e << "Query aborted: " << reason;
+    throw e;
+}
+
+}
@@ -0,0 +1,169 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CASTOR_BUDGET_H
+#define CASTOR_BUDGET_H
+
+#include <atomic>
+#include <limits>
+
+#include "util.h"
+
+namespace castor {
+
+/**
+ * Exception thrown when a search exceeds its budget or is cancelled.
+ */
+class BudgetExceeded : public CastorException {};
+
+/**
+ * Resource budget of a search: time, backtracks and scanned triples. The
+ * budget is charged by the solver and the store at cheap points (search
+ * nodes, backtracks and triples returned by triple ranges), which throw
+ * BudgetExceeded once a limit is reached or the search is cancelled. The
+ * clock is only read every CHECK_INTERVAL charges.
+ *
+ * A search interrupted by BudgetExceeded can be cleaned up by discarding its
+ * subtrees.
+ */
+class Budget {
+public:
+    /**
+     * Number of charges between two checks of the deadline.
+     */
+    static constexpr unsigned CHECK_INTERVAL = 1024;
+
+    Budget() { clear(); }
+
+    //! Non-copyable
+    Budget(const Budget&) = delete;
+    Budget& operator=(const Budget&) = delete;
+
+    /**
+     * Remove all limits, reset the counters and the cancellation flag.
+     */
+    void clear();
+
+    /**
+     * Limit the time of the search.
+     *
+     * @param ns time from now in nanoseconds
+     */
+    void limitTime(unsigned long long ns) { deadline_ = monotonicTime() + ns; }
+
+    /**
+     * Limit the number of backtracks.
+     *
+     * @param n number of backtracks from now
+     */
+    void limitBacktracks(unsigned long n) { maxBacktracks_ = backtracks_ + n; }
+
+    /**
+     * Limit the number of scanned triples.
+     *
+     * @param n number of triples from now
+     */
+    void limitTriples(unsigned long n) { maxTriples_ = triples_ + n; }
+
+    /**
+     * Cancel the search. May be called from any thread.
+     */
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+    /**
+     * Charge a search node.
+     *
+     * @throws BudgetExceeded
+     */
+    void node() {
+        if(--countdown_ == 0 || cancelled_.load(std::memory_order_relaxed))
+            check();
+    }
+
+    /**
+     * Charge a backtrack.
+     *
+     * @throws BudgetExceeded
+     */
+    void backtrack() {
+        if(++backtracks_ > maxBacktracks_)
+            exceeded("backtrack limit reached");
+        node();
+    }
+
+    /**
+     * Charge a scanned triple.
+     *
+     * @throws BudgetExceeded
+     */
+    void triple() {
+        if(++triples_ > maxTriples_)
+            exceeded("scanned triples limit reached");
+        node();
+    }
+
+private:
+    /**
+     * Check the deadline and the cancellation flag.
+     *
+     * @throws BudgetExceeded
+     */
+    void check();
+
+    /**
+     * @param reason the exceeded limit
+     * @throws BudgetExceeded
+     */
+    [[noreturn]] void exceeded(const char* reason);
+
+    unsigned countdown_; //!< charges before the next check
+    unsigned long long deadline_; //!< monotonic time in nanoseconds
+    unsigned long backtracks_;
+    unsigned long maxBacktracks_;
+    unsigned long triples_;
+    unsigned long maxTriples_;
+    std::atomic<bool> cancelled_;
+};
+
+/**
+ * Install a budget in an owner (a solver or a store) for the lifetime of the
+ * scope. The previous budget of the owner is restored when the scope is
+ * left, including by an exception.
+ *
+ * @param T class with budget() and budget(Budget*) accessors
+ */
+template<class T>
+class BudgetScope {
+public:
+    BudgetScope(T& owner, Budget* budget) :
+            owner_(owner), previous_(owner.budget()) {
+        owner.budget(budget);
+    }
+    ~BudgetScope() { owner_.budget(previous_); }
+
+    //! Non-copyable
+    BudgetScope(const BudgetScope&) = delete;
+    BudgetScope& operator=(const BudgetScope&) = delete;
+
+private:
+    T& owner_;
+    Budget* previous_;
+};
+
+}
+
+#endif // CASTOR_BUDGET_H
@@ -44,11 +44,12 @@ public:
     Value::id_t id() const { return id_; }
     bool operator!=(const NumApproxIterator& o) const { return id_ != o.id_; }
     NumApproxIterator& operator++() { ++id_; return *this; }
+    NumApproxIterator& operator--() { --id_; return *this; }
     NumApproxIterator& operator+=(long n) { id_ += n; return *this; }
     long operator-(NumApproxIterator& o) {
         return static_cast<long>(id_) - static_cast<long>(o.id_);
     }
-    long operator*() { return store_->lookupValue(id_).numapprox().lower(); }
+    long operator*() { return store_->numapprox(id_); }
 private:
     Store* store_;
     Value::id_t id_;
@@ -61,35 +62,33 @@ bool ArithmeticChannelConstraint::propagate() {
     ValueRange rng = store_->range(Value::CAT_NUMERIC);
     domcheck(x_->updateMin(rng.from));
     domcheck(x_->updateMax(rng.to));
-    if(min_.id() != x_->min())
-        min_ = store_->lookupValue(x_->min());
-    if(max_.id() != x_->max())
-        max_ = store_->lookupValue(x_->max());
-    if(n_->min() < min_.numapprox().lower()) {
-        domcheck(n_->updateMin(min_.numapprox().lower()));
-    } else if(n_->min() > min_.numapprox().lower()) {
-        if(n_->min() > max_.numapprox().lower())
+    long min = store_->numapprox(x_->min());
+    long max = store_->numapprox(x_->max());
+    if(n_->min() < min) {
+        domcheck(n_->updateMin(min));
+    } else if(n_->min() > min) {
+        if(n_->min() > max)
             return false;
         NumApproxIterator it = std::lower_bound(
-                    NumApproxIterator(store_, min_.id()),
-                    NumApproxIterator(store_, max_.id() + 1),
+                    NumApproxIterator(store_, x_->min()),
+                    NumApproxIterator(store_, x_->max() + 1),
                     n_->min());
         domcheck(x_->updateMin(it.id()));
-        min_ = store_->lookupValue(it.id());
-        domcheck(n_->updateMin(min_.numapprox().lower()));
+        min = store_->numapprox(it.id());
+        domcheck(n_->updateMin(min));
     }
-    if(n_->max() > max_.numapprox().lower()) {
-        domcheck(n_->updateMax(max_.numapprox().lower()));
-    } else if(n_->max() < max_.numapprox().lower()) {
-        if(n_->max() < min_.numapprox().lower())
+    if(n_->max() > max) {
+        domcheck(n_->updateMax(max));
+    } else if(n_->max() < max) {
+        if(n_->max() < min)
             return false;
         NumApproxIterator it = std::upper_bound(
-                    NumApproxIterator(store_, min_.id()),
-                    NumApproxIterator(store_, max_.id() + 1),
+                    NumApproxIterator(store_, x_->min()),
+                    NumApproxIterator(store_, x_->max() + 1),
                     n_->max());
         domcheck(x_->updateMax(it.id() - 1));
-        max_ = store_->lookupValue(it.id() - 1);
-        domcheck(n_->updateMax(max_.numapprox().lower()));
+        max = store_->numapprox(it.id() - 1);
+        domcheck(n_->updateMax(max));
     }
     if(n_->bound())
         done_ = true;
@@ -39,7 +39,6 @@ private:
     cp::RDFVar* x_;
     cp::NumVar* n_;
     cp::TriStateVar* b_;
-    Value min_, max_; //!< cached values
 };
 
 /**
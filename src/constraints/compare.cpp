@@ -22,21 +22,16 @@ namespace castor {
 VarEqConstraint::VarEqConstraint(Query* query, cp::RDFVar* x1, cp::RDFVar* x2,
                                  cp::TriStateVar *b) :
         Constraint(query->solver(), PRIOR_HIGH),
-        store_(query->store()), x1_(x1), x2_(x2), b_(b) {
+        store_(query->store()), x1_(x1), x2_(x2), b_(b),
+        delta1_(x1), delta2_(x2) {
     x1->registerChange(this);
     x2->registerChange(this);
-    x1->registerRestored(this);
-    x2->registerRestored(this);
     b->registerChange(this);
 }
 
-void VarEqConstraint::restored(cp::Trailable*) {
-    s1_ = x1_->size();
-    s2_ = x2_->size();
-}
-
 bool VarEqConstraint::post() {
-    restored(nullptr);
+    delta1_.reset();
+    delta2_.reset();
     return propagate();
 }
 
@@ -60,15 +55,15 @@ bool VarEqConstraint::propagate() {
     } else if(b_->bound() && b_->value() == RDF_TRUE) {
         unsigned n1 = x1->size();
         unsigned n2 = x2->size();
-        unsigned oldn1 = s1_;
-        unsigned oldn2 = s2_;
-        unsigned removed = (oldn1 - n1) + (oldn2 - n2);
+        unsigned removed1 = delta1_.size();
+        unsigned removed2 = delta2_.size();
+        unsigned removed = removed1 + removed2;
         /* removed is 0 on initial propagation. In such case, we must compute
          * the union of both domains.
          */
         if(removed > 0 && removed < n1 && removed < n2) {
-            for(unsigned i = n1; i < oldn1; i++) {
-                ValueRange eqClass = store_->eqClass((*x1)[i]);
+            for(unsigned i = 0; i < removed1; i++) {
+                ValueRange eqClass = store_->eqClass(delta1_[i]);
                 bool prune = true;
                 for(Value::id_t id : eqClass) {
                     if(x1->contains(id)) {
@@ -81,8 +76,8 @@ bool VarEqConstraint::propagate() {
                         domcheck(x2->remove(id));
                 }
             }
-            for(unsigned i = n2; i < oldn2; i++) {
-                ValueRange eqClass = store_->eqClass((*x2)[i]);
+            for(unsigned i = 0; i < removed2; i++) {
+                ValueRange eqClass = store_->eqClass(delta2_[i]);
                 bool prune = true;
                 for(Value::id_t id : eqClass) {
                     if(x2->contains(id)) {
@@ -123,8 +118,8 @@ bool VarEqConstraint::propagate() {
             }
             domcheck(x2->restrictToMarks());
         }
-        s1_ = x1_->size();
-        s2_ = x2_->size();
+        delta1_.reset();
+        delta2_.reset();
         if(x1_->bound() || x2_->bound())
             done_ = true; // TODO: also done if only eqClass remaining
     } else if(!b_->contains(RDF_TRUE)) {
@@ -292,22 +287,17 @@ bool VarLessConstraint::propagate() {
 
 VarSameTermConstraint::VarSameTermConstraint(Query *query, cp::RDFVar* x1,
                                              cp::RDFVar* x2, cp::TriStateVar *b) :
-    Constraint(query->solver(), PRIOR_HIGH), x1_(x1), x2_(x2), b_(b) {
+    Constraint(query->solver(), PRIOR_HIGH), x1_(x1), x2_(x2), b_(b),
+    delta1_(x1), delta2_(x2) {
     x1->registerChange(this);
     x2->registerChange(this);
-    x1->registerRestored(this);
-    x2->registerRestored(this);
     b->registerChange(this);
 }
 
-void VarSameTermConstraint::restored(cp::Trailable*) {
-    s1_ = x1_->size();
-    s2_ = x2_->size();
-}
-
 bool VarSameTermConstraint::post() {
     domcheck(b_->remove(RDF_ERROR));
-    restored(nullptr);
+    delta1_.reset();
+    delta2_.reset();
     return propagate();
 }
 
@@ -319,17 +309,17 @@ bool VarSameTermConstraint::propagate() {
     } else if(!b_->contains(RDF_FALSE)) { // b_ is RDF_TRUE
         unsigned n1 = x1->size();
         unsigned n2 = x2->size();
-        unsigned oldn1 = s1_;
-        unsigned oldn2 = s2_;
-        unsigned removed = (oldn1 - n1) + (oldn2 - n2);
+        unsigned removed1 = delta1_.size();
+        unsigned removed2 = delta2_.size();
+        unsigned removed = removed1 + removed2;
         /* removed is 0 on initial propagation. In such case, we must compute the
          * union of both domains.
          */
         if(removed > 0 && removed < n1 && removed < n2) {
-            for(unsigned i = n1; i < oldn1; i++)
-                domcheck(x2->remove((*x1)[i]));
-            for(unsigned i = n2; i < oldn2; i++)
-                domcheck(x1->remove((*x2)[i]));
+            for(unsigned i = 0; i < removed1; i++)
+                domcheck(x2->remove(delta1_[i]));
+            for(unsigned i = 0; i < removed2; i++)
+                domcheck(x1->remove(delta2_[i]));
         } else {
             if(n2 < n1) {
                 x1 = x2;
@@ -349,8 +339,8 @@ bool VarSameTermConstraint::propagate() {
             }
             domcheck(x2->restrictToMarks());
         }
-        s1_ = x1_->size();
-        s2_ = x2_->size();
+        delta1_.reset();
+        delta2_.reset();
         if(x1_->bound())
             done_ = true;
     } else if(!b_->contains(RDF_TRUE)) { // b_ is RDF_FALSE
@@ -29,11 +29,10 @@ namespace castor {
  * categories (or of categories Value::CAT_PLAIN_LANG or Value::CAT_OTHER).
  * Otherwise, b is RDF_FALSE.
  */
-class VarEqConstraint : public cp::Constraint, cp::TrailListener {
+class VarEqConstraint : public cp::Constraint {
 public:
     VarEqConstraint(Query* query, cp::RDFVar* x1, cp::RDFVar* x2,
                     cp::TriStateVar* b);
-    void restored(cp::Trailable* obj) override;
     bool post() override;
     bool propagate() override;
 
@@ -42,7 +41,8 @@ private:
     cp::RDFVar* x1_;
     cp::RDFVar* x2_;
     cp::TriStateVar* b_;
-    unsigned s1_, s2_; //!< previous size of the domain
+    cp::DomainDelta<Value::id_t> delta1_; //!< removed values of x1
+    cp::DomainDelta<Value::id_t> delta2_; //!< removed values of x2
 };
 
 /**
@@ -67,11 +67,10 @@ private:
  * Equality in sameTerm sense: sameTerm(x1, x2) <=> b.
  * No type error may occur, so b is never RDF_ERROR.
  */
-class VarSameTermConstraint : public cp::Constraint, cp::TrailListener {
+class VarSameTermConstraint : public cp::Constraint {
 public:
     VarSameTermConstraint(Query* query, cp::RDFVar* x1, cp::RDFVar* x2,
                           cp::TriStateVar* b);
-    void restored(cp::Trailable* obj) override;
     bool post() override;
     bool propagate() override;
 
@@ -79,7 +78,8 @@ private:
     cp::RDFVar* x1_;
     cp::RDFVar* x2_;
     cp::TriStateVar* b_;
-    unsigned s1_, s2_; //!< previous size of the domain
+    cp::DomainDelta<Value::id_t> delta1_; //!< removed values of x1
+    cp::DomainDelta<Value::id_t> delta2_; //!< removed values of x2
 };
 
 }
@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <algorithm>
+
 namespace castor {
 
 FilterConstraint::FilterConstraint(Query* query, Expression* expr,
@@ -48,14 +50,25 @@ bool FilterConstraint::propagate() {
         done_ = true;
     } else if(b_->bound()) {
         // all variables, except one, are bound -> forward checking
+        // The domain is evaluated in batches, such that the subexpressions
+        // not depending on the unbound variable are only evaluated once.
+        static constexpr unsigned BATCH_SIZE = Expression::BATCH_SIZE;
         TriState ebv = b_->value();
         cp::RDFVar* x = unbound->cp();
         x->clearMarks();
         unsigned n = x->size();
-        for(unsigned i = 0; i < n; i++) {
-            unbound->valueId((*x)[i]);
-            if(expr_->evaluateEBV() == ebv)
-                x->mark((*x)[i]);
+        Value::id_t ids[BATCH_SIZE];
+        Value buffers[BATCH_SIZE];
+        TriState results[BATCH_SIZE];
+        for(unsigned i = 0; i < n; i += BATCH_SIZE) {
+            unsigned batch = std::min(BATCH_SIZE, n - i);
+            for(unsigned j = 0; j < batch; j++)
+                ids[j] = (*x)[i + j];
+            expr_->evaluateEBVBatch(unbound, ids, batch, buffers, results);
+            for(unsigned j = 0; j < batch; j++) {
+                if(results[j] == ebv)
+                    x->mark(ids[j]);
+            }
         }
         domcheck(x->restrictToMarks());
         done_ = true;
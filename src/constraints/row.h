@@ -0,0 +1,59 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CASTOR_CONSTRAINTS_ROW_H
+#define CASTOR_CONSTRAINTS_ROW_H
+
+#include <vector>
+
+#include "solver/constraint.h"
+#include "query.h"
+
+namespace castor {
+
+/**
+ * Row constraint: x_i = row[i] for every i such that row[i] != 0. Variables
+ * with a zero entry are left untouched. The row is read when the constraint
+ * is posted, so that it may change between activations of the subtree.
+ */
+class RowConstraint : public cp::Constraint {
+public:
+    /**
+     * @param query the query
+     * @param vars the variables
+     * @param row pointer to the current row
+     */
+    RowConstraint(Query* query, const std::vector<cp::RDFVar*>& vars,
+                  const Value::id_t* const* row) :
+        Constraint(query->solver(), PRIOR_HIGH), vars_(vars), row_(row) {}
+
+    bool post() override {
+        for(unsigned i = 0; i < vars_.size(); i++) {
+            if((*row_)[i] != 0 && !vars_[i]->bind((*row_)[i]))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    std::vector<cp::RDFVar*> vars_;
+    const Value::id_t* const* row_;
+};
+
+}
+
+#endif // CASTOR_CONSTRAINTS_ROW_H
@@ -17,39 +17,207 @@
  */
 #include "triple.h"
 
+#include <algorithm>
+
 namespace castor {
 
-FCTripleConstraint::FCTripleConstraint(Query* query, RDFVarTriple triple) :
+/**
+ * @param first index of the first component
+ * @param second index of the second component
+ * @return the order starting with the given components
+ */
+static TripleOrder orderStartingWith(int first, int second) {
+    static const TripleOrder orders[3][3] = {
+        {TripleOrder::SPO, TripleOrder::SPO, TripleOrder::SOP},
+        {TripleOrder::PSO, TripleOrder::POS, TripleOrder::POS},
+        {TripleOrder::OSP, TripleOrder::OPS, TripleOrder::OSP}
+    };
+    return orders[first][second];
+}
+
+namespace {
+
+/**
+ * A domain holding less than one value out of SPARSE_DOMAIN_FACTOR within
+ * its bounds is scanned value run by value run.
+ */
+const unsigned SPARSE_DOMAIN_FACTOR = 8;
+
+}
+
+/**
+ * Split the domain of x into the intervals to scan for it. Sparse domains
+ * yield one interval per run of consecutive values (single values being
+ * point lookups). Dense domains yield [min,max] as separate lookups would
+ * not pay off.
+ *
+ * @param x a variable
+ * @return sorted disjoint intervals covering the domain of x
+ */
+static std::vector<Store::TripleRangeSet::Interval> domainIntervals(
+        cp::RDFVar* x) {
+    std::vector<Store::TripleRangeSet::Interval> intervals;
+    Value::id_t min = x->min();
+    Value::id_t max = x->max();
+    if(static_cast<unsigned long long>(x->size()) * SPARSE_DOMAIN_FACTOR >
+            static_cast<unsigned long long>(max - min) + 1) {
+        intervals.emplace_back(min, max);
+        return intervals;
+    }
+    std::vector<Value::id_t> values;
+    values.reserve(x->size());
+    for(unsigned i = 0; i < x->size(); i++) {
+        Value::id_t v = (*x)[i];
+        if(x->contains(v)) // skip values outside unsynchronized bounds
+            values.push_back(v);
+    }
+    std::sort(values.begin(), values.end());
+    for(Value::id_t v : values) {
+        if(!intervals.empty() && intervals.back().second + 1 == v)
+            intervals.back().second = v;
+        else
+            intervals.emplace_back(v, v);
+    }
+    return intervals;
+}
+
+FCTripleConstraint::FCTripleConstraint(Query* query, RDFVarTriple triple,
+                                       Triple constants) :
         Constraint(query->solver(), PRIOR_MEDIUM),
-        store_(query->store()), triple_(triple) {
-    for(int i = 0; i < triple_.COMPONENTS; i++)
-        triple_[i]->registerBind(this);
+        store_(query->store()), triple_(triple), constants_(constants) {
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(triple_[i])
+            triple_[i]->registerBind(this);
+    }
 }
 
 bool FCTripleConstraint::propagate() {
     Triple min, max;
     int unbound = -1;
+    int bound = -1;
+    bool wildcard = false;
     for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(constants_[i]) {
+            bound = i;
+            min[i] = max[i] = constants_[i];
+            continue;
+        }
+        if(!triple_[i]) {
+            wildcard = true;
+            min[i] = 0;
+            max[i] = store_->valuesCount();
+            continue;
+        }
         if(!triple_[i]->bound()) {
             if(unbound == -1)
                 unbound = i;
             else
                 return true; // too many unbound variables (> 1)
+        } else {
+            bound = i;
         }
         min[i] = triple_[i]->min();
         max[i] = triple_[i]->max();
     }
 
-    Store::TripleRange q(store_, min, max);
+    if(unbound == -1) {
+        // all variables are bound, just check
+        Store::TripleRange q(store_, min, max);
+        if(!q.next(nullptr))
+            return false;
+        done_ = true;
+        return true;
+    }
+
+    if(wildcard && bound == -1) {
+        // only wildcards besides the unbound variable: enumerate its distinct
+        // values from the index, skipping to the next one after each match
+        cp::RDFVar* x = triple_[unbound];
+        TripleOrder order = orderStartingWith(unbound, (unbound + 1) % 3);
+        x->clearMarks();
+        for(const auto& interval : domainIntervals(x)) {
+            min[unbound] = interval.first;
+            max[unbound] = interval.second;
+            Triple t;
+            while(min[unbound] <= max[unbound]) {
+                Store::TripleRange q(store_, min, max, order);
+                if(!q.next(&t))
+                    break;
+                x->mark(t[unbound]);
+                min[unbound] = t[unbound] + 1;
+            }
+        }
+        domcheck(x->restrictToMarks());
+        done_ = true;
+        return true;
+    }
+
+    TripleOrder order = TRIPLE_ORDER_AUTO;
+    if(wildcard) {
+        // scan the unbound variable right after the bound one
+        order = orderStartingWith(bound, unbound);
+    }
+    Store::TripleRangeSet q(store_, min, max, unbound,
+                            domainIntervals(triple_[unbound]), order);
+
+    triple_[unbound]->clearMarks();
+    Triple t;
+    while(q.next(&t))
+        triple_[unbound]->mark(t[unbound]);
+    domcheck(triple_[unbound]->restrictToMarks());
+    done_ = true;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<unsigned CONSTANTS>
+FCConstTripleConstraint<CONSTANTS>::FCConstTripleConstraint(
+        Query* query, RDFVarTriple triple, Triple constants) :
+        Constraint(query->solver(), PRIOR_MEDIUM),
+        store_(query->store()), triple_(triple), constants_(constants) {
+    for(int i = 0; i < Triple::COMPONENTS; i++) {
+        if(!(CONSTANTS & (1 << i)))
+            triple_[i]->registerBind(this);
+    }
+    // the unbound component comes last, as TRIPLE_ORDER_AUTO would choose
+    orders_[0] = TripleOrder::POS;
+    orders_[1] = TripleOrder::OSP;
+    orders_[2] = TripleOrder::SPO;
+}
+
+template<unsigned CONSTANTS>
+bool FCConstTripleConstraint<CONSTANTS>::propagate() {
+    Triple min, max;
+    int unbound = -1;
+    // CONSTANTS is known at compile time: this loop unrolls to straight code
+    for(int i = 0; i < Triple::COMPONENTS; i++) {
+        if(CONSTANTS & (1 << i)) {
+            min[i] = max[i] = constants_[i];
+        } else if(triple_[i]->bound()) {
+            min[i] = max[i] = triple_[i]->value();
+        } else if(unbound == -1) {
+            unbound = i;
+            min[i] = triple_[i]->min();
+            max[i] = triple_[i]->max();
+        } else {
+            return true; // too many unbound variables (> 1)
+        }
+    }
 
     if(unbound == -1) {
         // all variables are bound, just check
+        Store::TripleRange q(store_, min, max, TripleOrder::SPO);
         if(!q.next(nullptr))
             return false;
         done_ = true;
         return true;
     }
 
+    Store::TripleRangeSet q(store_, min, max, unbound,
+                            domainIntervals(triple_[unbound]),
+                            orders_[unbound]);
+
     triple_[unbound]->clearMarks();
     Triple t;
     while(q.next(&t))
@@ -59,19 +227,74 @@ bool FCTripleConstraint::propagate() {
     return true;
 }
 
+/**
+ * @return a new FCConstTripleConstraint<CONSTANTS>
+ */
+template<unsigned CONSTANTS>
+static cp::Constraint* makeFCConst(Query* query, RDFVarTriple triple,
+                                   Triple constants) {
+    return query->solver()->make<FCConstTripleConstraint<CONSTANTS>>(
+                query, triple, constants);
+}
+
+cp::Constraint* makeFCTripleConstraint(Query* query, RDFVarTriple triple,
+                                       Triple constants) {
+    unsigned mask = 0;
+    for(int i = 0; i < triple.COMPONENTS; i++) {
+        if(constants[i])
+            mask |= 1 << i;
+        else if(!triple[i]) // wildcard
+            return query->solver()->make<FCTripleConstraint>(query, triple,
+                                                             constants);
+    }
+    switch(mask) {
+    case 0: return makeFCConst<0>(query, triple, constants);
+    case 1: return makeFCConst<1>(query, triple, constants);
+    case 2: return makeFCConst<2>(query, triple, constants);
+    case 3: return makeFCConst<3>(query, triple, constants);
+    case 4: return makeFCConst<4>(query, triple, constants);
+    case 5: return makeFCConst<5>(query, triple, constants);
+    case 6: return makeFCConst<6>(query, triple, constants);
+    default: return makeFCConst<7>(query, triple, constants);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
-ExtraTripleConstraint::ExtraTripleConstraint(Query* query, RDFVarTriple triple) :
+ExtraTripleConstraint::ExtraTripleConstraint(Query* query, RDFVarTriple triple,
+                                             Triple constants) :
         Constraint(query->solver(), PRIOR_LOW),
-        store_(query->store()), triple_(triple) {
-    for(int i = 0; i < triple_.COMPONENTS; i++)
-        triple_[i]->registerBind(this);
+        store_(query->store()), triple_(triple), constants_(constants),
+        scanned_(query->solver()->trail(), -1) {
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(constants_[i])
+            continue;
+        triple_[i]->registerChange(this);
+        triple_[i]->registerRestored(this);
+        delta_[i].reset(new cp::DomainDelta<Value::id_t>(triple_[i]));
+        min_[i] = triple_[i]->min();
+        max_[i] = triple_[i]->max();
+    }
+}
+
+void ExtraTripleConstraint::restored(cp::Trailable* obj) {
+    // the residues were valid at the restored checkpoint
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(delta_[i] && obj == triple_[i]) {
+            min_[i] = triple_[i]->min();
+            max_[i] = triple_[i]->max();
+        }
+    }
 }
 
 bool ExtraTripleConstraint::propagate() {
     Triple min, max;
     int a = -1, b = -1;
     for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(constants_[i]) {
+            min[i] = max[i] = constants_[i];
+            continue;
+        }
         if(!triple_[i]->bound()) {
             if(a == -1)
                 a = i;
@@ -90,68 +313,289 @@ bool ExtraTripleConstraint::propagate() {
         return true;
     }
 
-    Store::TripleRange q(store_, min, max);
+    int bound = triple_.COMPONENTS - a - b; // the other component
+    if(scanned_ != bound) {
+        // new pair of unbound components, e.g., in a new branch
+        scanned_ = bound;
+        domcheck(scan(a, b, min, max));
+        sync();
+        return true;
+    }
+
+    /* Values leaving through the bounds do not show in the deltas, they are
+     * handled as removed values. Rescan when most values are gone.
+     */
+    unsigned long long removed = 0;
+    for(int x : {a, b}) {
+        removed += delta_[x]->size() + (min[x] - min_[x]) + (max_[x] - max[x]);
+    }
+    if(2 * removed > triple_[a]->size() + triple_[b]->size()) {
+        domcheck(scan(a, b, min, max));
+        sync();
+        return true;
+    }
+    for(int x : {a, b}) {
+        int y = a + b - x;
+        for(Value::id_t w = min_[x]; w < min[x]; w++)
+            domcheck(revise(y, x, w, min, max));
+        for(Value::id_t w = max_[x]; w > max[x]; w--)
+            domcheck(revise(y, x, w, min, max));
+    }
+    // the deltas grow with the values removed by revise()
+    unsigned processed[Triple::COMPONENTS] = {0, 0, 0};
+    bool progress = true;
+    while(progress) {
+        progress = false;
+        for(int x : {a, b}) {
+            int y = a + b - x;
+            for(; processed[x] < delta_[x]->size(); processed[x]++) {
+                domcheck(revise(y, x, (*delta_[x])[processed[x]], min, max));
+                progress = true;
+            }
+        }
+    }
+    sync();
+    return true;
+}
+
+bool ExtraTripleConstraint::valid(const Triple& t) const {
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(!constants_[i] && !triple_[i]->contains(t[i]))
+            return false;
+    }
+    return true;
+}
+
+void ExtraTripleConstraint::support(const Triple& t, int a, int b) {
+    residues_[a][t[a]] = t;
+    dependents_[b][t[b]].push_back(t[a]);
+}
+
+bool ExtraTripleConstraint::scan(int a, int b,
+                                 const Triple& min, const Triple& max) {
+    // restrict the scan with the sparser domain, right after the bound one
+    int x = triple_[a]->size() * static_cast<double>(max[b] - min[b]) <
+            triple_[b]->size() * static_cast<double>(max[a] - min[a]) ? a : b;
+    int bound = triple_.COMPONENTS - a - b; // the other component
+    Store::TripleRangeSet q(store_, min, max, x, domainIntervals(triple_[x]),
+                            orderStartingWith(bound, x));
 
-    triple_[a]->clearMarks();
-    triple_[b]->clearMarks();
+    for(int y : {a, b}) {
+        residues_[y].clear();
+        dependents_[y].clear();
+        triple_[y]->clearMarks();
+    }
     Triple t;
     while(q.next(&t)) {
         if(triple_[a]->contains(t[a]) && triple_[b]->contains(t[b])) {
+            // the first triple found for a value becomes its residue
+            if(residues_[a].find(t[a]) == residues_[a].end())
+                support(t, a, b);
+            if(residues_[b].find(t[b]) == residues_[b].end())
+                support(t, b, a);
             triple_[a]->mark(t[a]);
             triple_[b]->mark(t[b]);
         }
     }
     domcheck(triple_[a]->restrictToMarks());
     domcheck(triple_[b]->restrictToMarks());
-    done_ = true;
     return true;
 }
 
-////////////////////////////////////////////////////////////////////////////////
+bool ExtraTripleConstraint::revise(int a, int b, Value::id_t w,
+                                   const Triple& min, const Triple& max) {
+    auto it = dependents_[b].find(w);
+    if(it == dependents_[b].end())
+        return true;
+    // new supports never use w, so the list does not grow meanwhile
+    const std::vector<Value::id_t>& values = it->second;
+    cp::RDFVar* x = triple_[a];
+    for(unsigned i = 0; i < values.size(); i++) {
+        Value::id_t v = values[i];
+        if(!x->contains(v))
+            continue;
+        auto res = residues_[a].find(v);
+        if(res != residues_[a].end() && valid(res->second))
+            continue;
+        Triple from = min, to = max;
+        from[a] = to[a] = v;
+        Store::TripleRange q(store_, from, to);
+        Triple t;
+        bool found = false;
+        while(q.next(&t)) {
+            if(triple_[b]->contains(t[b])) {
+                support(t, a, b);
+                found = true;
+                break;
+            }
+        }
+        if(!found)
+            domcheck(x->remove(v));
+    }
+    return true;
+}
 
-STRTripleConstraint::STRTripleConstraint(Query *query, RDFVarTriple triple) :
-    Constraint(query->solver(), PRIOR_LOW),
-    store_(query->store()), triple_(triple),
-    supports_(query->solver()->trail(), 0, query->store()->triplesCount() - 1) {
-    for(int i = 0; i < triple_.COMPONENTS; i++)
-        triple_[i]->registerChange(this);
+void ExtraTripleConstraint::sync() {
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(!delta_[i])
+            continue;
+        delta_[i]->reset();
+        min_[i] = triple_[i]->min();
+        max_[i] = triple_[i]->max();
+    }
 }
 
-bool STRTripleConstraint::propagate() {
-    for(int j = 0; j < triple_.COMPONENTS; j++)
-        triple_[j]->clearMarks();
-    for(unsigned i = 0; i < supports_.size(); i++) {
-        Triple t = store_->triple(supports_[i]);
-        bool valid = true;
-        for(int j = 0; j < triple_.COMPONENTS; j++) {
-            if(!triple_[j]->contains(t[j])) {
-                valid = false;
-                break;
-            }
+////////////////////////////////////////////////////////////////////////////////
+
+CTTripleConstraint::CTTripleConstraint(Query *query, RDFVarTriple triple,
+                                       Triple constants) :
+    Constraint(query->solver(), PRIOR_LOW),
+    store_(query->store()), triple_(triple) {
+    Triple min, max;
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(constants[i]) {
+            min[i] = max[i] = constants[i];
+            continue;
+        }
+        if(!triple_[i]) {
+            min[i] = 0;
+            max[i] = store_->valuesCount();
+            continue;
         }
-        if(valid) {
-            int fullyMarked = 0;
-            for(int j = 0; j < triple_.COMPONENTS; j++) {
-                triple_[j]->mark(t[j]);
-                if(triple_[j]->marked() == triple_[j]->size())
-                    ++fullyMarked;
+        min[i] = triple_[i]->min();
+        max[i] = triple_[i]->max();
+        triple_[i]->registerChange(this);
+        delta_[i].reset(new cp::DomainDelta<Value::id_t>(triple_[i]));
+    }
+    Store::TripleRange q(store_, min, max);
+    Triple t;
+    unsigned n = 0;
+    while(q.next(&t)) {
+        unsigned w = n / cp::ReversibleSparseBitSet::WORD_BITS;
+        word_t bit = word_t(1) << (n % cp::ReversibleSparseBitSet::WORD_BITS);
+        for(int i = 0; i < triple_.COMPONENTS; i++) {
+            if(!delta_[i])
+                continue;
+            Support& s = supports_[i][t[i]];
+            if(s.index.empty() || s.index.back() != w) {
+                s.index.push_back(w);
+                s.words.push_back(0);
             }
-            if(fullyMarked == triple_.COMPONENTS)
-                return true;
-        } else {
-            supports_.remove(i);
-            i--;
+            s.words.back() |= bit;
         }
+        n++;
+    }
+    table_.reset(new cp::ReversibleSparseBitSet(query->solver()->trail(), n));
+}
+
+bool CTTripleConstraint::post() {
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(delta_[i])
+            update(i, true);
+    }
+    if(table_->empty())
+        return false;
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(delta_[i])
+            domcheck(filter(i));
+    }
+    sync();
+    return true;
+}
+
+bool CTTripleConstraint::propagate() {
+    bool changed = false;
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(!delta_[i])
+            continue;
+        cp::RDFVar* x = triple_[i];
+        bool reset = x->min() != min_[i] || x->max() != max_[i] ||
+                     delta_[i]->size() >= x->size();
+        if(reset || delta_[i]->size() > 0)
+            changed |= update(i, reset);
     }
-    int bound = 0;
-    for(int j = 0; j < triple_.COMPONENTS; j++) {
-        domcheck(triple_[j]->restrictToMarks());
-        if(triple_[j]->bound())
-            ++bound;
+    if(table_->empty())
+        return false;
+    int bound = triple_.COMPONENTS;
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(!delta_[i])
+            continue;
+        if(changed)
+            domcheck(filter(i));
+        if(!triple_[i]->bound())
+            --bound;
     }
+    sync();
     if(bound >= triple_.COMPONENTS - 1)
         done_ = true;
     return true;
 }
 
+bool CTTripleConstraint::update(int i, bool reset) {
+    cp::RDFVar* x = triple_[i];
+    table_->clearMask();
+    auto addToMask = [this, i](Value::id_t v) {
+        auto it = supports_[i].find(v);
+        if(it == supports_[i].end())
+            return;
+        const Support& s = it->second;
+        for(unsigned j = 0; j < s.index.size(); j++)
+            table_->addToMask(s.index[j], s.words[j]);
+    };
+    if(reset) {
+        for(unsigned k = 0; k < x->size(); k++) {
+            Value::id_t v = (*x)[k];
+            if(x->contains(v)) // skip values outside unsynchronized bounds
+                addToMask(v);
+        }
+    } else {
+        for(unsigned k = 0; k < delta_[i]->size(); k++)
+            addToMask((*delta_[i])[k]);
+        table_->reverseMask();
+    }
+    return table_->intersectWithMask();
+}
+
+bool CTTripleConstraint::filter(int i) {
+    cp::RDFVar* x = triple_[i];
+    if(x->bound())
+        return true; // the current table only contains its value
+    for(unsigned k = 0; k < x->size(); k++) {
+        Value::id_t v = (*x)[k];
+        if(!x->contains(v))
+            continue;
+        auto it = supports_[i].find(v);
+        bool supported = false;
+        if(it != supports_[i].end()) {
+            Support& s = it->second;
+            if(table_->word(s.index[s.residue]) & s.words[s.residue]) {
+                supported = true;
+            } else {
+                for(unsigned j = 0; j < s.index.size(); j++) {
+                    if(table_->word(s.index[j]) & s.words[j]) {
+                        s.residue = j;
+                        supported = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if(!supported) {
+            domcheck(x->remove(v));
+            k--;
+        }
+    }
+    return true;
+}
+
+void CTTripleConstraint::sync() {
+    for(int i = 0; i < triple_.COMPONENTS; i++) {
+        if(!delta_[i])
+            continue;
+        delta_[i]->reset();
+        min_[i] = triple_[i]->min();
+        max_[i] = triple_[i]->max();
+    }
+}
+
 }
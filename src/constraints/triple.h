@@ -18,55 +18,218 @@
 #ifndef CASTOR_CONSTRAINTS_TRIPLE_H
 #define CASTOR_CONSTRAINTS_TRIPLE_H
 
+#include <unordered_map>
+#include <memory>
+
 #include "config.h"
 #include "solver/constraint.h"
+#include "solver/bitset.h"
 #include "query.h"
 #include "pattern.h"
 
 namespace castor {
 
+/* Triple constraints take the variables of the triple pattern and the values
+ * of its constant components (0 for a variable). The variable of a constant
+ * component is nullptr: constants get no solver variable.
+ *
+ * A component that is neither a variable nor a constant is a wildcard. It
+ * stands for a variable occurring nowhere else: the constraint only ensures
+ * that some value exists for it, without ever restricting its domain.
+ */
+
 /**
  * Triple constraint with Forward-Checking consistency.
  */
 class FCTripleConstraint : public cp::Constraint {
 public:
-    FCTripleConstraint(Query* query, RDFVarTriple triple);
+    FCTripleConstraint(Query* query, RDFVarTriple triple, Triple constants);
     bool propagate() override;
 
 private:
     Store* store_; //!< The store containing the triples
-    RDFVarTriple triple_; //!< The triple pattern
+    RDFVarTriple triple_; //!< The variables of the triple pattern
+    Triple constants_; //!< Values of the constant components (0 otherwise)
 };
 
+/**
+ * Triple constraint with Forward-Checking consistency, specialized on its
+ * constant components. Bit i of CONSTANTS is set if component i is a
+ * constant. Constant values are hard-coded and the index order used when
+ * each component is the last unbound one is chosen at construction. Wildcard
+ * components are not supported.
+ */
+template<unsigned CONSTANTS>
+class FCConstTripleConstraint : public cp::Constraint {
+public:
+    FCConstTripleConstraint(Query* query, RDFVarTriple triple,
+                            Triple constants);
+    bool propagate() override;
+
+private:
+    Store* store_; //!< The store containing the triples
+    RDFVarTriple triple_; //!< The variables of the triple pattern
+    Triple constants_; //!< Values of the constant components
+    /**
+     * Index order to scan when component i is the last unbound one.
+     */
+    TripleOrder orders_[Triple::COMPONENTS];
+};
+
+/**
+ * Create the forward-checking constraint for a triple pattern: a
+ * specialization on its constant components if it has no wildcard, a
+ * generic FCTripleConstraint otherwise.
+ *
+ * @param query the query
+ * @param triple the variables of the triple pattern
+ * @param constants values of the constant components (0 otherwise)
+ * @return the new constraint, owned by the solver of the query
+ */
+cp::Constraint* makeFCTripleConstraint(Query* query, RDFVarTriple triple,
+                                       Triple constants);
+
 /**
  * Triple constraint providing extra pruning.
  *
  * The smaller the domains, the better the extra pruning will be. Thus this
  * constraint has low priority to ensure it comes last in the propagation
  * queue.
+ *
+ * While exactly two components are unbound, the constraint stays active and
+ * keeps a residual support triple for each value. The first propagation for
+ * a pair of unbound components scans the matching triples once. Later
+ * wake-ups only look up again the values whose residue contains a value
+ * removed since the previous propagation, found through a reverse index of
+ * the residues.
  */
-class ExtraTripleConstraint : public cp::Constraint {
+class ExtraTripleConstraint : public cp::Constraint, public cp::TrailListener {
 public:
-    ExtraTripleConstraint(Query* query, RDFVarTriple triple);
+    ExtraTripleConstraint(Query* query, RDFVarTriple triple, Triple constants);
     bool propagate() override;
+    void restored(cp::Trailable* obj) override;
 
 private:
+    /**
+     * @param t a triple matching the constant components
+     * @return whether all variable components of t are in the domains
+     */
+    bool valid(const Triple& t) const;
+    /**
+     * Record t as the residual support of value t[a] of component a, b being
+     * the other unbound component.
+     */
+    void support(const Triple& t, int a, int b);
+    /**
+     * Rebuild the supports of components a and b with a single scan.
+     */
+    bool scan(int a, int b, const Triple& min, const Triple& max);
+    /**
+     * Look up the values of component a whose residue used the value w of
+     * component b, now removed. Values without support are removed.
+     */
+    bool revise(int a, int b, Value::id_t w,
+                const Triple& min, const Triple& max);
+    /**
+     * Forget the deltas and remember the bounds of the components.
+     */
+    void sync();
+
     Store* store_; //!< The store containing the triples
-    RDFVarTriple triple_; //!< The triple pattern
+    RDFVarTriple triple_; //!< The variables of the triple pattern
+    Triple constants_; //!< Values of the constant components (0 otherwise)
+    /**
+     * Residual support of the values of each component. Residues are not
+     * restored on backtrack: they are only hints checked with valid().
+     */
+    std::unordered_map<Value::id_t, Triple> residues_[Triple::COMPONENTS];
+    /**
+     * Reverse index of the residues: dependents_[b][w] lists the values of
+     * the other unbound component whose residue was recorded with value w in
+     * component b. Entries may be outdated and are checked on use.
+     */
+    std::unordered_map<Value::id_t, std::vector<Value::id_t>>
+            dependents_[Triple::COMPONENTS];
+    /**
+     * Bound component when the supports were last rebuilt by scan(), -1 if
+     * none. As it is restored on backtrack, the residues are known to be
+     * valid at the last propagation whenever it matches the bound component.
+     */
+    cp::Reversible<int> scanned_;
+    /**
+     * Removed values of each variable component, nullptr otherwise.
+     */
+    std::unique_ptr<cp::DomainDelta<Value::id_t>> delta_[Triple::COMPONENTS];
+    /**
+     * Bounds at the last propagation or restoration. Values leaving through
+     * the bounds do not show in the deltas.
+     */
+    Value::id_t min_[Triple::COMPONENTS], max_[Triple::COMPONENTS];
 };
 
 /**
- * Triple constraint using the STR algorithm.
+ * Triple constraint using the Compact-Table algorithm.
+ *
+ * The table holds the triples matching the constant components, collected
+ * once at construction. The current table is a reversible sparse bitset over
+ * these triples and each value has a mask of the triples it occurs in.
  */
-class STRTripleConstraint : public cp::Constraint {
+class CTTripleConstraint : public cp::Constraint {
 public:
-    STRTripleConstraint(Query* query, RDFVarTriple triple);
+    CTTripleConstraint(Query* query, RDFVarTriple triple, Triple constants);
+    bool post() override;
     bool propagate() override;
 
 private:
+    typedef cp::ReversibleSparseBitSet::word_t word_t;
+
+    /**
+     * Triples of the table containing a value, as a list of non-zero words.
+     */
+    struct Support {
+        std::vector<unsigned> index; //!< indices of the words
+        std::vector<word_t> words;   //!< the words
+        unsigned residue = 0;        //!< last word found in the current table
+    };
+
+    /**
+     * Remove from the current table the triples no longer matching the
+     * domain of component i.
+     *
+     * @param i a varying component
+     * @param reset rebuild from the whole domain instead of the delta
+     * @return whether some triples were removed
+     */
+    bool update(int i, bool reset);
+    /**
+     * Remove the values of component i without support in the current table.
+     *
+     * @param i a varying component
+     * @return false if the domain becomes empty
+     */
+    bool filter(int i);
+    /**
+     * Forget the deltas and remember the bounds of the varying components.
+     */
+    void sync();
+
     Store* store_; //!< The store containing the triples
-    RDFVarTriple triple_; //!< The triple pattern
-    cp::ReversibleSet<unsigned> supports_; //!< support triples
+    RDFVarTriple triple_; //!< The variables of the triple pattern
+    std::unique_ptr<cp::ReversibleSparseBitSet> table_; //!< current table
+    /**
+     * Supports of each value of a varying component (neither a wildcard nor
+     * a constant).
+     */
+    std::unordered_map<Value::id_t, Support> supports_[Triple::COMPONENTS];
+    /**
+     * Removed values of each varying component, nullptr otherwise.
+     */
+    std::unique_ptr<cp::DomainDelta<Value::id_t>> delta_[Triple::COMPONENTS];
+    /**
+     * Bounds at the last propagation. Bounds updates do not show in the
+     * deltas, so changed bounds trigger a reset-based update.
+     */
+    Value::id_t min_[Triple::COMPONENTS], max_[Triple::COMPONENTS];
 };
 
 }
@@ -31,6 +31,11 @@
 
 namespace castor {
 
+template<class T, class... Args>
+T* Expression::make(Args&&... args) {
+    return query_->solver()->make<T>(std::forward<Args>(args)...);
+}
+
 UnaryExpression::UnaryExpression(Expression* arg) :
         Expression(arg->query()), arg_(arg) {
     vars_ = arg->variables();
@@ -113,6 +118,10 @@ RegExExpression::~RegExExpression() {
 TriState Expression::evaluateEBV(Value& buffer) {
     if(!evaluate(buffer))
         return RDF_ERROR;
+    return ebv(buffer);
+}
+
+TriState Expression::ebv(Value& buffer) {
     buffer.ensureInterpreted(*query_->store());
     if(buffer.isBoolean()) {
         return buffer.boolean() ? RDF_TRUE : RDF_FALSE;
@@ -141,27 +150,25 @@ bool VariableExpression::evaluate(Value& result) {
     Value::id_t id = variable_->valueId();
     if(id == 0)
         return false;
-    result = query_->store()->lookupValue(id);
+    result = query_->lookupValue(id);
+    if(id <= query_->store()->valuesCount())
+        query_->store()->interpretNumber(result);
     return true;
 }
 
-bool BangExpression::evaluate(Value& result) {
-    TriState ebv = arg_->evaluateEBV(result);
-    if(ebv == RDF_ERROR)
+bool BangExpression::apply(Value& result) {
+    TriState val = ebv(result);
+    if(val == RDF_ERROR)
         return false;
-    result.fillBoolean(ebv == RDF_TRUE ? false : true);
+    result.fillBoolean(val == RDF_TRUE ? false : true);
     return true;
 }
 
-bool UPlusExpression::evaluate(Value& result) {
-    if(!arg_->evaluate(result) || !result.isNumeric())
-        return false;
-    return true;
+bool UPlusExpression::apply(Value& result) {
+    return result.isNumeric();
 }
 
-bool UMinusExpression::evaluate(Value& result) {
-    if(!arg_->evaluate(result))
-        return false;
+bool UMinusExpression::apply(Value& result) {
     result.ensureInterpreted(*query_->store());
     if(result.isInteger())
         result.fillInteger(-result.integer());
@@ -179,37 +186,31 @@ bool BoundExpression::evaluate(Value& result) {
     return true;
 }
 
-bool IsIriExpression::evaluate(Value& result) {
-    if(!arg_->evaluate(result))
-        return false;
+bool IsIriExpression::apply(Value& result) {
     result.fillBoolean(result.isURI());
     return true;
 }
 
-bool IsBlankExpression::evaluate(Value& result) {
-    if(!arg_->evaluate(result))
-        return false;
+bool IsBlankExpression::apply(Value& result) {
     result.fillBoolean(result.isBlank());
     return true;
 }
 
-bool IsLiteralExpression::evaluate(Value& result) {
-    if(!arg_->evaluate(result))
-        return false;
+bool IsLiteralExpression::apply(Value& result) {
     result.fillBoolean(result.isLiteral());
     return true;
 }
 
-bool StrExpression::evaluate(Value& result) {
-    if(!arg_->evaluate(result) || result.isBlank())
+bool StrExpression::apply(Value& result) {
+    if(result.isBlank())
         return false;
     result.ensureLexical();
     result.fillSimpleLiteral(std::move(result.lexical()));
     return true;
 }
 
-bool LangExpression::evaluate(Value& result) {
-    if(!arg_->evaluate(result) || !result.isPlain())
+bool LangExpression::apply(Value& result) {
+    if(!result.isPlain())
         return false;
     if(result.isSimple())
         result.fillSimpleLiteral(String(""));
@@ -218,8 +219,8 @@ bool LangExpression::evaluate(Value& result) {
     return true;
 }
 
-bool DatatypeExpression::evaluate(Value& result) {
-    if(!arg_->evaluate(result) || !result.isLiteral() || result.isPlainWithLang())
+bool DatatypeExpression::apply(Value& result) {
+    if(!result.isLiteral() || result.isPlainWithLang())
         return false;
     if(result.isSimple()) {
         result.fillURI(String(       "http://www.w3.org/2001/XMLSchema#string",
@@ -231,9 +232,12 @@ bool DatatypeExpression::evaluate(Value& result) {
     return true;
 }
 
-bool OrExpression::evaluate(Value& result) {
-    TriState left = arg1_->evaluateEBV(result);
-    TriState right = arg2_->evaluateEBV(result);
+namespace {
+
+/**
+ * Compute the logical-or of two EBVs.
+ */
+inline bool logicalOr(TriState left, TriState right, Value& result) {
     if(left == RDF_TRUE || right == RDF_TRUE)
         result.fillBoolean(true);
     else if(left == RDF_FALSE && right == RDF_FALSE)
@@ -243,9 +247,10 @@ bool OrExpression::evaluate(Value& result) {
     return true;
 }
 
-bool AndExpression::evaluate(Value& result) {
-    TriState left = arg1_->evaluateEBV(result);
-    TriState right = arg2_->evaluateEBV(result);
+/**
+ * Compute the logical-and of two EBVs.
+ */
+inline bool logicalAnd(TriState left, TriState right, Value& result) {
     if(left == RDF_FALSE || right == RDF_FALSE)
         result.fillBoolean(false);
     else if(left == RDF_TRUE && right == RDF_TRUE)
@@ -255,10 +260,29 @@ bool AndExpression::evaluate(Value& result) {
     return true;
 }
 
-bool EqExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !arg2_->evaluate(right))
-        return false;
+}
+
+bool OrExpression::evaluate(Value& result) {
+    TriState left = arg1_->evaluateEBV(result);
+    TriState right = arg2_->evaluateEBV(result);
+    return logicalOr(left, right, result);
+}
+
+bool OrExpression::apply(Value& result, Value& right) {
+    return logicalOr(ebv(result), ebv(right), result);
+}
+
+bool AndExpression::evaluate(Value& result) {
+    TriState left = arg1_->evaluateEBV(result);
+    TriState right = arg2_->evaluateEBV(result);
+    return logicalAnd(left, right, result);
+}
+
+bool AndExpression::apply(Value& result, Value& right) {
+    return logicalAnd(ebv(result), ebv(right), result);
+}
+
+bool EqExpression::apply(Value& result, Value& right) {
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
     switch(result.equals(right)) {
@@ -276,10 +300,7 @@ bool EqExpression::evaluate(Value& result) {
     }
 }
 
-bool NEqExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !arg2_->evaluate(right))
-        return false;
+bool NEqExpression::apply(Value& result, Value& right) {
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
     switch(result.equals(right)) {
@@ -297,10 +318,7 @@ bool NEqExpression::evaluate(Value& result) {
     }
 }
 
-bool LTExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !arg2_->evaluate(right))
-        return false;
+bool LTExpression::apply(Value& result, Value& right) {
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
     int cmp = result.compare(right);
@@ -313,10 +331,7 @@ bool LTExpression::evaluate(Value& result) {
     return true;
 }
 
-bool GTExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !arg2_->evaluate(right))
-        return false;
+bool GTExpression::apply(Value& result, Value& right) {
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
     int cmp = result.compare(right);
@@ -329,10 +344,7 @@ bool GTExpression::evaluate(Value& result) {
     return true;
 }
 
-bool LEExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !arg2_->evaluate(right))
-        return false;
+bool LEExpression::apply(Value& result, Value& right) {
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
     int cmp = result.compare(right);
@@ -345,10 +357,7 @@ bool LEExpression::evaluate(Value& result) {
     return true;
 }
 
-bool GEExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !arg2_->evaluate(right))
-        return false;
+bool GEExpression::apply(Value& result, Value& right) {
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
     int cmp = result.compare(right);
@@ -361,10 +370,8 @@ bool GEExpression::evaluate(Value& result) {
     return true;
 }
 
-bool StarExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !result.isNumeric() ||
-       !arg2_->evaluate(right) || !right.isNumeric())
+bool StarExpression::apply(Value& result, Value& right) {
+    if(!result.isNumeric() || !right.isNumeric())
         return false;
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
@@ -378,10 +385,8 @@ bool StarExpression::evaluate(Value& result) {
     return true;
 }
 
-bool SlashExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !result.isNumeric() ||
-       !arg2_->evaluate(right) || !right.isNumeric())
+bool SlashExpression::apply(Value& result, Value& right) {
+    if(!result.isNumeric() || !right.isNumeric())
         return false;
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
@@ -397,10 +402,8 @@ bool SlashExpression::evaluate(Value& result) {
     return true;
 }
 
-bool PlusExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !result.isNumeric() ||
-       !arg2_->evaluate(right) || !right.isNumeric())
+bool PlusExpression::apply(Value& result, Value& right) {
+    if(!result.isNumeric() || !right.isNumeric())
         return false;
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
@@ -414,10 +417,8 @@ bool PlusExpression::evaluate(Value& result) {
     return true;
 }
 
-bool MinusExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !result.isNumeric() ||
-       !arg2_->evaluate(right) || !right.isNumeric())
+bool MinusExpression::apply(Value& result, Value& right) {
+    if(!result.isNumeric() || !right.isNumeric())
         return false;
     result.ensureInterpreted(*query_->store());
     right.ensureInterpreted(*query_->store());
@@ -431,20 +432,15 @@ bool MinusExpression::evaluate(Value& result) {
     return true;
 }
 
-bool SameTermExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !arg2_->evaluate(right))
-        return false;
+bool SameTermExpression::apply(Value& result, Value& right) {
     result.ensureLexical();
     right.ensureLexical();
     result.fillBoolean(result == right);
     return true;
 }
 
-bool LangMatchesExpression::evaluate(Value& result) {
-    Value right;
-    if(!arg1_->evaluate(result) || !result.isSimple() ||
-       !arg2_->evaluate(right)  || !right.isSimple())
+bool LangMatchesExpression::apply(Value& result, Value& right) {
+    if(!result.isSimple() || !right.isSimple())
         return false;
     result.ensureDirectStrings(*query_->store());
     right.ensureDirectStrings(*query_->store());
@@ -498,40 +494,166 @@ bool RegExExpression::evaluate(Value& result) {
 //    throw CastorException() << "Unsupported operator: casting";
 //}
 
+////////////////////////////////////////////////////////////////////////////////
+// Batch evaluation functions
+
+void Expression::evaluateBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                               Value* results, bool* ok) {
+    assert(n <= BATCH_SIZE);
+    if(!vars_.contains(x)) {
+        Value result;
+        bool valid = evaluate(result);
+        for(unsigned i = 0; i < n; i++) {
+            ok[i] = valid;
+            if(valid)
+                results[i] = result;
+        }
+        return;
+    }
+    for(unsigned i = 0; i < n; i++) {
+        x->valueId(ids[i]);
+        ok[i] = evaluate(results[i]);
+    }
+}
+
+void Expression::evaluateEBVBatch(Variable* x, const Value::id_t* ids,
+                                  unsigned n, Value* buffers,
+                                  TriState* results) {
+    if(!vars_.contains(x)) {
+        TriState result = evaluateEBV(buffers[0]);
+        for(unsigned i = 0; i < n; i++)
+            results[i] = result;
+        return;
+    }
+    bool ok[BATCH_SIZE];
+    evaluateBatch(x, ids, n, buffers, ok);
+    for(unsigned i = 0; i < n; i++)
+        results[i] = ok[i] ? ebv(buffers[i]) : RDF_ERROR;
+}
+
+void ValueExpression::evaluateBatch(Variable* x, const Value::id_t* ids,
+                                    unsigned n, Value* results, bool* ok) {
+    for(unsigned i = 0; i < n; i++) {
+        results[i].fillCopy(*value_, false); // shallow copy
+        ok[i] = true;
+    }
+}
+
+void VariableExpression::evaluateBatch(Variable* x, const Value::id_t* ids,
+                                       unsigned n, Value* results, bool* ok) {
+    if(x != variable_) {
+        Expression::evaluateBatch(x, ids, n, results, ok);
+        return;
+    }
+    for(unsigned i = 0; i < n; i++) {
+        ok[i] = ids[i] != 0;
+        if(ok[i]) {
+            results[i] = query_->lookupValue(ids[i]);
+            if(ids[i] <= query_->store()->valuesCount())
+                query_->store()->interpretNumber(results[i]);
+        }
+    }
+}
+
+void UnaryExpression::evaluateBatch(Variable* x, const Value::id_t* ids,
+                                    unsigned n, Value* results, bool* ok) {
+    if(!vars_.contains(x)) {
+        Expression::evaluateBatch(x, ids, n, results, ok);
+        return;
+    }
+    arg_->evaluateBatch(x, ids, n, results, ok);
+    for(unsigned i = 0; i < n; i++)
+        ok[i] = ok[i] && apply(results[i]);
+}
+
+void BinaryExpression::evaluateBatch(Variable* x, const Value::id_t* ids,
+                                     unsigned n, Value* results, bool* ok) {
+    if(!vars_.contains(x)) {
+        Expression::evaluateBatch(x, ids, n, results, ok);
+        return;
+    }
+    arg1_->evaluateBatch(x, ids, n, results, ok);
+    if(arg2_->variables().contains(x)) {
+        Value right[BATCH_SIZE];
+        bool okRight[BATCH_SIZE];
+        arg2_->evaluateBatch(x, ids, n, right, okRight);
+        for(unsigned i = 0; i < n; i++)
+            ok[i] = ok[i] && okRight[i] && apply(results[i], right[i]);
+    } else {
+        // evaluate the second argument once and give each application a
+        // shallow copy, as apply() may modify it
+        Value shared;
+        bool valid = arg2_->evaluate(shared);
+        if(valid)
+            shared.ensureInterpreted(*query_->store());
+        for(unsigned i = 0; i < n; i++) {
+            if(ok[i] && valid) {
+                Value right;
+                right.fillCopy(shared, false);
+                ok[i] = apply(results[i], right);
+            } else {
+                ok[i] = false;
+            }
+        }
+    }
+}
+
+void OrExpression::evaluateBatch(Variable* x, const Value::id_t* ids,
+                                 unsigned n, Value* results, bool* ok) {
+    if(!vars_.contains(x)) {
+        Expression::evaluateBatch(x, ids, n, results, ok);
+        return;
+    }
+    TriState left[BATCH_SIZE], right[BATCH_SIZE];
+    arg1_->evaluateEBVBatch(x, ids, n, results, left);
+    arg2_->evaluateEBVBatch(x, ids, n, results, right);
+    for(unsigned i = 0; i < n; i++)
+        ok[i] = logicalOr(left[i], right[i], results[i]);
+}
+
+void AndExpression::evaluateBatch(Variable* x, const Value::id_t* ids,
+                                  unsigned n, Value* results, bool* ok) {
+    if(!vars_.contains(x)) {
+        Expression::evaluateBatch(x, ids, n, results, ok);
+        return;
+    }
+    TriState left[BATCH_SIZE], right[BATCH_SIZE];
+    arg1_->evaluateEBVBatch(x, ids, n, results, left);
+    arg2_->evaluateEBVBatch(x, ids, n, results, right);
+    for(unsigned i = 0; i < n; i++)
+        ok[i] = logicalAnd(left[i], right[i], results[i]);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Posting constraints
 
 void Expression::post(cp::Subtree& sub, cp::TriStateVar* b) {
-    sub.add(new FilterConstraint(query_, this, b));
+    sub.add(make<FilterConstraint>(query_, this, b));
 }
 
 #ifdef CASTOR_SPECIALIZED_CSTR
 
 void BangExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
-    cp::TriStateVar* x = new cp::TriStateVar(query_->solver());
-    query_->solver()->collect(x);
+    cp::TriStateVar* x = make<cp::TriStateVar>(query_->solver());
     arg_->post(sub, x);
-    sub.add(new NotConstraint(query_, x, b));
+    sub.add(make<NotConstraint>(query_, x, b));
 }
 
 void OrExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
-    cp::TriStateVar* b1 = new cp::TriStateVar(query_->solver());
-    cp::TriStateVar* b2 = new cp::TriStateVar(query_->solver());
-    query_->solver()->collect(b1);
-    query_->solver()->collect(b2);
+    cp::TriStateVar* b1 = make<cp::TriStateVar>(query_->solver());
+    cp::TriStateVar* b2 = make<cp::TriStateVar>(query_->solver());
     arg1_->post(sub, b1);
     arg2_->post(sub, b2);
-    sub.add(new OrConstraint(query_, b1, b2, b));
+    sub.add(make<OrConstraint>(query_, b1, b2, b));
 }
 
 void AndExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
-    cp::TriStateVar* b1 = new cp::TriStateVar(query_->solver());
-    cp::TriStateVar* b2 = new cp::TriStateVar(query_->solver());
-    query_->solver()->collect(b1);
-    query_->solver()->collect(b2);
+    cp::TriStateVar* b1 = make<cp::TriStateVar>(query_->solver());
+    cp::TriStateVar* b2 = make<cp::TriStateVar>(query_->solver());
     arg1_->post(sub, b1);
     arg2_->post(sub, b2);
-    sub.add(new AndConstraint(query_, b1, b2, b));
+    sub.add(make<AndConstraint>(query_, b1, b2, b));
 }
 
 void EqualityExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
@@ -549,7 +671,7 @@ void EqualityExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
             val.ensureInterpreted(*query_->store());
             postConst(sub, x, val, b);
         } else {
-            sub.add(new ErrorConstraint(query_, b));
+            sub.add(make<ErrorConstraint>(query_, b));
         }
     } else if(var2 && arg1_->isConstant()) {
         Value val;
@@ -559,24 +681,22 @@ void EqualityExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
             val.ensureInterpreted(*query_->store());
             postConst(sub, x, val, b);
         } else {
-            sub.add(new ErrorConstraint(query_, b));
+            sub.add(make<ErrorConstraint>(query_, b));
         }
     } else {
         Expression::post(sub, b);
 #ifdef CASTOR_ARITHMETIC_CSTR
         if(arg1_->isArithmetic() && arg2_->isArithmetic()) {
             // Redundant arithmetic equality constraint
-            cp::NumVar* x = new cp::NumVar(query_->solver(),
-                                           NumRange::NEG_INFINITY,
-                                           NumRange::POS_INFINITY);
-            query_->solver()->collect(x);
-            cp::NumVar* y = new cp::NumVar(query_->solver(),
-                                           NumRange::NEG_INFINITY,
-                                           NumRange::POS_INFINITY);
-            query_->solver()->collect(y);
+            cp::NumVar* x = make<cp::NumVar>(query_->solver(),
+                                             NumRange::NEG_INFINITY,
+                                             NumRange::POS_INFINITY);
+            cp::NumVar* y = make<cp::NumVar>(query_->solver(),
+                                             NumRange::NEG_INFINITY,
+                                             NumRange::POS_INFINITY);
             arg1_->postArithmetic(sub, x, b);
             arg2_->postArithmetic(sub, y, b);
-            sub.add(new NumEqConstraint(query_, x, y, b));
+            sub.add(make<NumEqConstraint>(query_, x, y, b));
         }
 #endif
     }
@@ -584,7 +704,7 @@ void EqualityExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
 
 void EqExpression::postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                             cp::TriStateVar* b) {
-    sub.add(new VarEqConstraint(query_, x1, x2, b));
+    sub.add(make<VarEqConstraint>(query_, x1, x2, b));
 }
 void EqExpression::postConst(cp::Subtree& sub, cp::RDFVar* x, Value& v,
                              cp::TriStateVar* b) {
@@ -593,40 +713,37 @@ void EqExpression::postConst(cp::Subtree& sub, cp::RDFVar* x, Value& v,
         // No value equivalent to v2 exists in the store
         Value::Category cat = v.category();
         if(cat <= Value::CAT_URI) {
-            sub.add(new FalseConstraint(query_, b)); // Always comparable
+            sub.add(make<FalseConstraint>(query_, b)); // Always comparable
         } else if(cat > Value::CAT_DATETIME) {
-            sub.add(new ErrorConstraint(query_, b)); // Always type error
+            sub.add(make<ErrorConstraint>(query_, b)); // Always type error
         } else {
-            sub.add(new NotTrueConstraint(query_, b));
-            sub.add(new InRangeConstraint(query_, x,
-                                          query_->store()->range(cat), b));
+            sub.add(make<NotTrueConstraint>(query_, b));
+            sub.add(make<InRangeConstraint>(query_, x,
+                                            query_->store()->range(cat), b));
         }
     } else {
-        cp::RDFVar* x2 = new cp::RDFVar(query_->solver(), rng.from, rng.from);
-        query_->solver()->collect(x2);
-        sub.add(new VarEqConstraint(query_, x, x2, b));
+        cp::RDFVar* x2 = make<cp::RDFVar>(query_->solver(), rng.from, rng.from);
+        sub.add(make<VarEqConstraint>(query_, x, x2, b));
     }
 }
 
 void NEqExpression::post(cp::Subtree &sub, cp::TriStateVar *b) {
-    cp::TriStateVar* b2 = new cp::TriStateVar(query_->solver());
-    query_->solver()->collect(b2);
+    cp::TriStateVar* b2 = make<cp::TriStateVar>(query_->solver());
     EqExpression::post(sub, b2);
-    sub.add(new NotConstraint(query_, b2, b));
+    sub.add(make<NotConstraint>(query_, b2, b));
 }
 
 void SameTermExpression::postVars(cp::Subtree &sub, cp::RDFVar *x1,
                                   cp::RDFVar *x2, cp::TriStateVar *b) {
-    sub.add(new VarSameTermConstraint(query_, x1, x2, b));
+    sub.add(make<VarSameTermConstraint>(query_, x1, x2, b));
 }
 void SameTermExpression::postConst(cp::Subtree &sub, cp::RDFVar *x, Value &v,
                                    cp::TriStateVar *b) {
     if(v.validId()) {
-        cp::RDFVar* x2 = new cp::RDFVar(query_->solver(), v.id(), v.id());
-        query_->solver()->collect(x2);
-        sub.add(new VarSameTermConstraint(query_, x, x2, b));
+        cp::RDFVar* x2 = make<cp::RDFVar>(query_->solver(), v.id(), v.id());
+        sub.add(make<VarSameTermConstraint>(query_, x, x2, b));
     } else {
-        sub.add(new FalseConstraint(query_, b));
+        sub.add(make<FalseConstraint>(query_, b));
     }
 }
 
@@ -643,11 +760,11 @@ void InequalityExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
             cp::RDFVar* x = var1->variable()->cp();
             query_->store()->resolve(val);
             val.ensureInterpreted(*query_->store());
-            sub.add(new InRangeConstraint(query_, x,
+            sub.add(make<InRangeConstraint>(query_, x,
                         query_->store()->range(val.category()), b));
             postConst(sub, x, val, b);
         } else {
-            sub.add(new ErrorConstraint(query_, b));
+            sub.add(make<ErrorConstraint>(query_, b));
         }
     } else if(var2 && arg1_->isConstant()) {
         Value val;
@@ -655,26 +772,24 @@ void InequalityExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
             cp::RDFVar* x = var2->variable()->cp();
             query_->store()->resolve(val);
             val.ensureInterpreted(*query_->store());
-            sub.add(new InRangeConstraint(query_, x,
-                                          query_->store()->range(val.category()),
-                                          b));
+            sub.add(make<InRangeConstraint>(query_, x,
+                                            query_->store()->range(val.category()),
+                                            b));
             postConst(sub, val, x, b);
         } else {
-            sub.add(new ErrorConstraint(query_, b));
+            sub.add(make<ErrorConstraint>(query_, b));
         }
     } else {
         Expression::post(sub, b);
 #ifdef CASTOR_ARITHMETIC_CSTR
         if(arg1_->isArithmetic() && arg2_->isArithmetic()) {
             // Redundant arithmetic equality constraint
-            cp::NumVar* x = new cp::NumVar(query_->solver(),
-                                           NumRange::NEG_INFINITY,
-                                           NumRange::POS_INFINITY);
-            query_->solver()->collect(x);
-            cp::NumVar* y = new cp::NumVar(query_->solver(),
-                                           NumRange::NEG_INFINITY,
-                                           NumRange::POS_INFINITY);
-            query_->solver()->collect(y);
+            cp::NumVar* x = make<cp::NumVar>(query_->solver(),
+                                             NumRange::NEG_INFINITY,
+                                             NumRange::POS_INFINITY);
+            cp::NumVar* y = make<cp::NumVar>(query_->solver(),
+                                             NumRange::NEG_INFINITY,
+                                             NumRange::POS_INFINITY);
             arg1_->postArithmetic(sub, x, b);
             arg2_->postArithmetic(sub, y, b);
             postArithmetic(sub, x, y, b);
@@ -685,81 +800,81 @@ void InequalityExpression::post(cp::Subtree& sub, cp::TriStateVar* b) {
 
 void LTExpression::postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                             cp::TriStateVar* b) {
-    sub.add(new VarLessConstraint(query_, x1, x2, b, false));
+    sub.add(make<VarLessConstraint>(query_, x1, x2, b, false));
 }
 void LTExpression::postConst(cp::Subtree& sub, cp::RDFVar* x1, Value& v2,
                              cp::TriStateVar* b) {
-    sub.add(new ConstLEConstraint(query_, x1,
+    sub.add(make<ConstLEConstraint>(query_, x1,
                         query_->store()->eqClass(v2).from - 1, b));
 }
 void LTExpression::postConst(cp::Subtree& sub, Value& v1, cp::RDFVar* x2,
                              cp::TriStateVar* b) {
-    sub.add(new ConstGEConstraint(query_, x2,
+    sub.add(make<ConstGEConstraint>(query_, x2,
                         query_->store()->eqClass(v1).to + 1, b));
 }
 void LTExpression::postArithmetic(cp::Subtree &sub, cp::NumVar *x,
                                   cp::NumVar *y, cp::TriStateVar *b) {
-    sub.add(new NumLessConstraint(query_, x, y, b));
+    sub.add(make<NumLessConstraint>(query_, x, y, b));
 }
 
 
 void GTExpression::postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                             cp::TriStateVar* b) {
-    sub.add(new VarLessConstraint(query_, x2, x1, b, false));
+    sub.add(make<VarLessConstraint>(query_, x2, x1, b, false));
 }
 void GTExpression::postConst(cp::Subtree& sub, cp::RDFVar* x1, Value& v2,
                              cp::TriStateVar* b) {
-    sub.add(new ConstGEConstraint(query_, x1,
+    sub.add(make<ConstGEConstraint>(query_, x1,
                         query_->store()->eqClass(v2).to + 1, b));
 }
 void GTExpression::postConst(cp::Subtree& sub, Value& v1, cp::RDFVar* x2,
                              cp::TriStateVar* b) {
-    sub.add(new ConstLEConstraint(query_, x2,
+    sub.add(make<ConstLEConstraint>(query_, x2,
                         query_->store()->eqClass(v1).from - 1, b));
 }
 void GTExpression::postArithmetic(cp::Subtree &sub, cp::NumVar *x,
                                   cp::NumVar *y, cp::TriStateVar *b) {
-    sub.add(new NumLessConstraint(query_, y, x, b));
+    sub.add(make<NumLessConstraint>(query_, y, x, b));
 }
 
 
 void LEExpression::postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                             cp::TriStateVar* b) {
-    sub.add(new VarLessConstraint(query_, x1, x2, b, true));
+    sub.add(make<VarLessConstraint>(query_, x1, x2, b, true));
 }
 void LEExpression::postConst(cp::Subtree& sub, cp::RDFVar* x1, Value& v2,
                              cp::TriStateVar* b) {
-    sub.add(new ConstLEConstraint(query_, x1,
+    sub.add(make<ConstLEConstraint>(query_, x1,
                         query_->store()->eqClass(v2).to, b));
 }
 void LEExpression::postConst(cp::Subtree& sub, Value& v1, cp::RDFVar* x2,
                              cp::TriStateVar* b) {
-    sub.add(new ConstGEConstraint(query_, x2,
+    sub.add(make<ConstGEConstraint>(query_, x2,
                         query_->store()->eqClass(v1).from, b));
 }
 void LEExpression::postArithmetic(cp::Subtree &sub, cp::NumVar *x,
                                   cp::NumVar *y, cp::TriStateVar *b) {
-    sub.add(new NumLessConstraint(query_, x, y, b));
+    sub.add(make<NumLessConstraint>(query_, x, y, b));
 }
 
 
 void GEExpression::postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                             cp::TriStateVar* b) {
-    sub.add(new VarLessConstraint(query_, x2, x1, b, true));
+    sub.add(make<VarLessConstraint>(query_, x2, x1, b, true));
 }
 void GEExpression::postConst(cp::Subtree& sub, cp::RDFVar* x1, Value& v2,
                              cp::TriStateVar* b) {
-    sub.add(new ConstGEConstraint(query_, x1,
+    sub.add(make<ConstGEConstraint>(query_, x1,
                         query_->store()->eqClass(v2).from, b));
 }
 void GEExpression::postConst(cp::Subtree& sub, Value& v1, cp::RDFVar* x2,
                              cp::TriStateVar* b) {
-    sub.add(new ConstLEConstraint(query_, x2,
+    sub.add(make<ConstLEConstraint>(query_, x2,
                         query_->store()->eqClass(v1).to, b));
 }
 void GEExpression::postArithmetic(cp::Subtree &sub, cp::NumVar *x,
                                   cp::NumVar *y, cp::TriStateVar *b) {
-    sub.add(new NumLessConstraint(query_, y, x, b));
+    sub.add(make<NumLessConstraint>(query_, y, x, b));
 }
 
 #endif // CASTOR_SPECIALIZED_CSTR
@@ -769,39 +884,35 @@ void GEExpression::postArithmetic(cp::Subtree &sub, cp::NumVar *x,
 
 void ValueExpression::postArithmetic(cp::Subtree &sub, cp::NumVar *n,
                                      cp::TriStateVar *b) {
-    sub.add(new NumConstantConstraint(query_, n, value_->numapprox(), b));
+    sub.add(make<NumConstantConstraint>(query_, n, value_->numapprox(), b));
 }
 
 void VariableExpression::postArithmetic(cp::Subtree &sub, cp::NumVar *n,
                                         cp::TriStateVar *b) {
-    sub.add(new ArithmeticChannelConstraint(query_, variable_->cp(), n, b));
+    sub.add(make<ArithmeticChannelConstraint>(query_, variable_->cp(), n, b));
 }
 
 void PlusExpression::postArithmetic(cp::Subtree& sub, cp::NumVar* n,
                                     cp::TriStateVar* b) {
-    cp::NumVar* x = new cp::NumVar(query_->solver(), NumRange::NEG_INFINITY,
-                                   NumRange::POS_INFINITY);
-    query_->solver()->collect(x);
-    cp::NumVar* y = new cp::NumVar(query_->solver(), NumRange::NEG_INFINITY,
-                                   NumRange::POS_INFINITY);
-    query_->solver()->collect(y);
+    cp::NumVar* x = make<cp::NumVar>(query_->solver(), NumRange::NEG_INFINITY,
+                                     NumRange::POS_INFINITY);
+    cp::NumVar* y = make<cp::NumVar>(query_->solver(), NumRange::NEG_INFINITY,
+                                     NumRange::POS_INFINITY);
     arg1_->postArithmetic(sub, x, b);
     arg2_->postArithmetic(sub, y, b);
-    sub.add(new SumConstraint(query_, x, y, n));
+    sub.add(make<SumConstraint>(query_, x, y, n));
 }
 
 void MinusExpression::postArithmetic(cp::Subtree& sub, cp::NumVar* n,
                                      cp::TriStateVar* b) {
-    cp::NumVar* x = new cp::NumVar(query_->solver(), NumRange::NEG_INFINITY,
-                                   NumRange::POS_INFINITY);
-    query_->solver()->collect(x);
-    cp::NumVar* y = new cp::NumVar(query_->solver(), NumRange::NEG_INFINITY,
-                                   NumRange::POS_INFINITY);
-    query_->solver()->collect(y);
+    cp::NumVar* x = make<cp::NumVar>(query_->solver(), NumRange::NEG_INFINITY,
+                                     NumRange::POS_INFINITY);
+    cp::NumVar* y = make<cp::NumVar>(query_->solver(), NumRange::NEG_INFINITY,
+                                     NumRange::POS_INFINITY);
     arg1_->postArithmetic(sub, x, b);
     arg2_->postArithmetic(sub, y, b);
     // x - y = n  <=>  x = n + y
-    sub.add(new SumConstraint(query_, n, y, x));
+    sub.add(make<SumConstraint>(query_, n, y, x));
 }
 
 }
@@ -125,7 +125,53 @@ public:
      */
     bool isTrue() { return evaluateEBV() == RDF_TRUE; }
 
+    //! Maximum number of values in a batch evaluation
+    static constexpr unsigned BATCH_SIZE = 256;
+
+    /**
+     * Evaluate the expression for a batch of values of variable x, the other
+     * variables keeping their current assignment. Subexpressions not depending
+     * on x are only evaluated once. The value of x is undefined afterwards.
+     *
+     * @param x the variable
+     * @param ids the values of x
+     * @param n the number of values (at most BATCH_SIZE)
+     * @param[out] results values to fill in with the results
+     * @param[out] ok false on evaluation error, true otherwise
+     */
+    virtual void evaluateBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                               Value* results, bool* ok);
+
+    /**
+     * Evaluate the EBV of the expression for a batch of values of variable x.
+     *
+     * @param x the variable
+     * @param ids the values of x
+     * @param n the number of values (at most BATCH_SIZE)
+     * @param buffers value buffers to be used during evaluation
+     * @param[out] results the effective boolean values
+     */
+    void evaluateEBVBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                          Value* buffers, TriState* results);
+
 protected:
+    /**
+     * Compute the effective boolean value of an evaluated expression.
+     *
+     * @param value the result of the evaluation
+     * @return the effective boolean value
+     */
+    TriState ebv(Value& value);
+
+    /**
+     * Construct a variable or constraint owned by the solver of the query.
+     *
+     * @param args arguments of the constructor
+     * @return the new object
+     */
+    template<class T, class... Args>
+    T* make(Args&&... args);
+
     /**
      * Parent query.
      */
@@ -151,12 +197,26 @@ public:
         return this;
     }
 
+    bool evaluate(Value& result) override {
+        return arg_->evaluate(result) && apply(result);
+    }
+    void evaluateBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                       Value* results, bool* ok) override;
+
     /**
      * @return argument
      */
     Expression* argument() { return arg_; }
 
 protected:
+    /**
+     * Apply the operator on the evaluated argument.
+     *
+     * @param[in,out] result the argument, to be replaced by the result
+     * @return false on evaluation error, true otherwise
+     */
+    virtual bool apply(Value& result) = 0;
+
     Expression* arg_; //!< argument
 };
 
@@ -185,7 +245,24 @@ public:
      */
     Expression* right() { return arg2_; }
 
+    bool evaluate(Value& result) override {
+        Value right;
+        return arg1_->evaluate(result) && arg2_->evaluate(right) &&
+               apply(result, right);
+    }
+    void evaluateBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                       Value* results, bool* ok) override;
+
 protected:
+    /**
+     * Apply the operator on the evaluated arguments.
+     *
+     * @param[in,out] result the first argument, to be replaced by the result
+     * @param right the second argument
+     * @return false on evaluation error, true otherwise
+     */
+    virtual bool apply(Value& result, Value& right) = 0;
+
     Expression* arg1_; //!< first argument
     Expression* arg2_; //!< second argument
 };
@@ -198,6 +275,8 @@ public:
     ValueExpression(Query* query, Value* value);
     ~ValueExpression();
     bool evaluate(Value& result) override;
+    void evaluateBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                       Value* results, bool* ok) override;
     bool isArithmetic() override { return value_->isNumeric(); }
     void postArithmetic(cp::Subtree &sub, cp::NumVar *n,
                         cp::TriStateVar *b) override;
@@ -218,6 +297,8 @@ class VariableExpression : public Expression {
 public:
     VariableExpression(Variable* variable);
     bool evaluate(Value& result) override;
+    void evaluateBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                       Value* results, bool* ok) override;
     bool isArithmetic() override { return true; }
     void postArithmetic(cp::Subtree &sub, cp::NumVar *n,
                         cp::TriStateVar *b) override;
@@ -255,7 +336,7 @@ class BangExpression : public UnaryExpression {
 public:
     BangExpression(Expression* arg) :
         UnaryExpression(arg) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void post(cp::Subtree& sub, cp::TriStateVar* b) override;
 #endif
@@ -268,7 +349,7 @@ class UPlusExpression : public UnaryExpression {
 public:
     UPlusExpression(Expression* arg) : UnaryExpression(arg) {}
     UPlusExpression(UnaryExpression&& o) : UnaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 };
 
 /**
@@ -278,7 +359,7 @@ class UMinusExpression : public UnaryExpression {
 public:
     UMinusExpression(Expression* arg) : UnaryExpression(arg) {}
     UMinusExpression(UnaryExpression&& o) : UnaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 };
 
 /**
@@ -288,7 +369,7 @@ class IsIriExpression : public UnaryExpression {
 public:
     IsIriExpression(Expression* arg) : UnaryExpression(arg) {}
     IsIriExpression(UnaryExpression&& o) : UnaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 };
 
 /**
@@ -298,7 +379,7 @@ class IsBlankExpression : public UnaryExpression {
 public:
     IsBlankExpression(Expression* arg) : UnaryExpression(arg) {}
     IsBlankExpression(UnaryExpression&& o) : UnaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 };
 
 /**
@@ -308,7 +389,7 @@ class IsLiteralExpression : public UnaryExpression {
 public:
     IsLiteralExpression(Expression* arg) : UnaryExpression(arg) {}
     IsLiteralExpression(UnaryExpression&& o) : UnaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 };
 
 /**
@@ -318,7 +399,7 @@ class StrExpression : public UnaryExpression {
 public:
     StrExpression(Expression* arg) : UnaryExpression(arg) {}
     StrExpression(UnaryExpression&& o) : UnaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 };
 
 /**
@@ -328,7 +409,7 @@ class LangExpression : public UnaryExpression {
 public:
     LangExpression(Expression* arg) : UnaryExpression(arg) {}
     LangExpression(UnaryExpression&& o) : UnaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 };
 
 /**
@@ -338,7 +419,7 @@ class DatatypeExpression : public UnaryExpression {
 public:
     DatatypeExpression(Expression* arg) : UnaryExpression(arg) {}
     DatatypeExpression(UnaryExpression&& o) : UnaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result) override;
 };
 
 /**
@@ -349,6 +430,9 @@ public:
     OrExpression(Expression* arg1, Expression* arg2) :
         BinaryExpression(arg1, arg2) {}
     bool evaluate(Value& result) override;
+    void evaluateBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                       Value* results, bool* ok) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void post(cp::Subtree &sub, cp::TriStateVar *b) override;
 #endif
@@ -362,6 +446,9 @@ public:
     AndExpression(Expression* arg1, Expression* arg2) :
         BinaryExpression(arg1, arg2) {}
     bool evaluate(Value& result) override;
+    void evaluateBatch(Variable* x, const Value::id_t* ids, unsigned n,
+                       Value* results, bool* ok) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void post(cp::Subtree& sub, cp::TriStateVar* b) override;
 #endif
@@ -400,7 +487,7 @@ public:
     EqExpression(Expression* arg1, Expression* arg2) :
         EqualityExpression(arg1, arg2) {}
     EqExpression(BinaryExpression&& o) : EqualityExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                   cp::TriStateVar* b) override;
@@ -417,7 +504,7 @@ public:
     NEqExpression(Expression* arg1, Expression* arg2) :
             EqExpression(arg1, arg2) {}
     NEqExpression(BinaryExpression&& o) : EqExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void post(cp::Subtree &sub, cp::TriStateVar *b) override;
 #endif
@@ -466,7 +553,7 @@ public:
     LTExpression(Expression* arg1, Expression* arg2) :
             InequalityExpression(arg1, arg2) {}
     LTExpression(BinaryExpression&& o) : InequalityExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                   cp::TriStateVar* b) override;
@@ -487,7 +574,7 @@ public:
     GTExpression(Expression* arg1, Expression* arg2) :
             InequalityExpression(arg1, arg2) {}
     GTExpression(BinaryExpression&& o) : InequalityExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                   cp::TriStateVar* b) override;
@@ -508,7 +595,7 @@ public:
     LEExpression(Expression* arg1, Expression* arg2) :
             InequalityExpression(arg1, arg2) {}
     LEExpression(BinaryExpression&& o) : InequalityExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                   cp::TriStateVar* b) override;
@@ -529,7 +616,7 @@ public:
     GEExpression(Expression* arg1, Expression* arg2) :
             InequalityExpression(arg1, arg2) {}
     GEExpression(BinaryExpression&& o) : InequalityExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void postVars(cp::Subtree& sub, cp::RDFVar* x1, cp::RDFVar* x2,
                   cp::TriStateVar* b) override;
@@ -550,7 +637,7 @@ public:
     StarExpression(Expression* arg1, Expression* arg2) :
             BinaryExpression(arg1, arg2) {}
     StarExpression(BinaryExpression&& o) : BinaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 };
 
 /**
@@ -561,7 +648,7 @@ public:
     SlashExpression(Expression* arg1, Expression* arg2) :
             BinaryExpression(arg1, arg2) {}
     SlashExpression(BinaryExpression&& o) : BinaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 };
 
 /**
@@ -572,7 +659,7 @@ public:
     PlusExpression(Expression* arg1, Expression* arg2) :
             BinaryExpression(arg1, arg2) {}
     PlusExpression(BinaryExpression&& o) : BinaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
     bool isArithmetic() override {
         return arg1_->isArithmetic() && arg2_->isArithmetic();
     }
@@ -588,7 +675,7 @@ public:
     MinusExpression(Expression* arg1, Expression* arg2) :
             BinaryExpression(arg1, arg2) {}
     MinusExpression(BinaryExpression&& o) : BinaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
     bool isArithmetic() override {
         return arg1_->isArithmetic() && arg2_->isArithmetic();
     }
@@ -603,7 +690,7 @@ class SameTermExpression : public EqualityExpression {
 public:
     SameTermExpression(Expression* arg1, Expression* arg2) :
         EqualityExpression(arg1, arg2) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 #ifdef CASTOR_SPECIALIZED_CSTR
     void postVars(cp::Subtree &sub, cp::RDFVar *x1, cp::RDFVar *x2,
                   cp::TriStateVar *b) override;
@@ -620,7 +707,7 @@ public:
     LangMatchesExpression(Expression* arg1, Expression* arg2) :
             BinaryExpression(arg1, arg2) {}
     LangMatchesExpression(BinaryExpression&& o) : BinaryExpression(std::move(o)) {}
-    bool evaluate(Value& result) override;
+    bool apply(Value& result, Value& right) override;
 };
 
 /**
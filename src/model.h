@@ -705,6 +705,29 @@ public:
     void numapprox(NumRange rng) { assert(isNumeric());
                                    numapprox_ = rng; }
 
+    /**
+     * Set the interpretation of an xsd:integer without parsing the lexical.
+     * @pre isInteger() && !interpreted()
+     * @param value integer representation of the lexical
+     */
+    void interpretInteger(long value) { assert(isInteger() && !interpreted());
+                                        interpreted_ = INTERPRETED_UNOWNED;
+                                        integer_ = value;
+                                        if(numapprox_.empty())
+                                            numapprox_ = NumRange(value); }
+
+    /**
+     * Set the interpretation of an xsd:double or xsd:float without parsing
+     * the lexical.
+     * @pre isFloating() && !interpreted()
+     * @param value floating point representation of the lexical
+     */
+    void interpretFloating(double value) { assert(isFloating() && !interpreted());
+                                           interpreted_ = INTERPRETED_UNOWNED;
+                                           floating_ = value;
+                                           if(numapprox_.empty())
+                                               numapprox_ = NumRange(value); }
+
     /**
      * @return whether the literal been interpreted
      */
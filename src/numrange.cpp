@@ -19,6 +19,9 @@
 
 namespace castor {
 
+constexpr long NumRange::POS_INFINITY;
+constexpr long NumRange::NEG_INFINITY;
+
 const XSDDecimal NumRange::DECIMAL_POS_INFINITY(NumRange::POS_INFINITY);
 
 const XSDDecimal NumRange::DECIMAL_NEG_INFINITY(NumRange::NEG_INFINITY);
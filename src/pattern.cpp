@@ -17,30 +17,107 @@
  */
 #include "pattern.h"
 
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
 #include "config.h"
 #include "query.h"
+#include "rowcache.h"
 #include "constraints/unary.h"
 #include "constraints/triple.h"
 
 namespace castor {
 
+namespace {
+
+/**
+ * Maximum estimated cardinality of a right subpattern to be materialized
+ */
+const double HASH_JOIN_MAX_CARDINALITY = 1 << 20;
+
+/**
+ * Maximum number of values stored in the row cache of a compound pattern
+ */
+const std::size_t ROW_CACHE_BUDGET = 1 << 22;
+
+/**
+ * Names of the triple orders
+ */
+const char* TRIPLE_ORDER_NAMES[TRIPLE_ORDERS] = {
+    "SPO", "SOP", "PSO", "POS", "OSP", "OPS"
+};
+
+/**
+ * Write a duration in milliseconds.
+ *
+ * @param out output stream
+ * @param time duration in nanoseconds
+ */
+void writeTime(std::ostream& out, unsigned long long time) {
+    time /= 1000;
+    out << time / 1000 << '.' << std::setw(3) << std::setfill('0')
+        << time % 1000 << std::setfill(' ') << "ms";
+}
+
+}
+
 std::ostream& operator<<(std::ostream& out, const Pattern& p) {
     p.print(out);
     return out;
 }
 
-BasicPattern::BasicPattern(Query* query) :
-    Pattern(query), sub_(query->solver()) {}
+void Pattern::analyze(bool enable) {
+    analyzing_ = enable;
+    if(enable)
+        stats_ = Stats();
+}
 
-BasicPattern::~BasicPattern() {
-    for(unsigned i = 0; i < triples_.size(); i++) {
-        for(int j = 0; j < TriplePattern::COMPONENTS; j++) {
-            if(!triples_[i][j].isVariable())
-                delete cptriples_[i][j];
-        }
+bool Pattern::analyzedNext() {
+    cp::Solver* solver = query_->solver();
+    Store* store = query_->store();
+    Stats start;
+    start.backtracks = solver->statBacktracks();
+    start.propagate = solver->statPropagate();
+    start.triples = store->statTriplesScanned();
+    start.cacheHits = store->statTripleCacheHits();
+    start.cacheMisses = store->statTripleCacheMisses();
+    start.time = monotonicTime();
+    bool result = search();
+    stats_.time += monotonicTime() - start.time;
+    stats_.calls++;
+    if(result)
+        stats_.solutions++;
+    stats_.backtracks += solver->statBacktracks() - start.backtracks;
+    stats_.propagate += solver->statPropagate() - start.propagate;
+    stats_.triples += store->statTriplesScanned() - start.triples;
+    stats_.cacheHits += store->statTripleCacheHits() - start.cacheHits;
+    stats_.cacheMisses += store->statTripleCacheMisses() - start.cacheMisses;
+    return result;
+}
+
+void Pattern::explainNode(std::ostream& out, int indent,
+                          const std::string& name) {
+    out << ws(indent) << name << " (estimate: " << cardinality() << ")";
+    if(analyzing_) {
+        out << " [solutions: " << stats_.solutions
+            << ", calls: " << stats_.calls
+            << ", backtracks: " << stats_.backtracks
+            << ", propagate: " << stats_.propagate
+            << ", triples: " << stats_.triples
+            << ", cache hit: " << stats_.cacheHits
+            << ", cache miss: " << stats_.cacheMisses << ", time: ";
+        writeTime(out, stats_.time);
+        out << "]";
     }
+    out << std::endl;
 }
 
+BasicPattern::BasicPattern(Query* query) :
+    Pattern(query), sub_(query->solver()), projected_(false), distinct_(false),
+    needed_(query), filtered_(query) {}
+
 void BasicPattern::add(const TriplePattern& triple) {
     triples_.push_back(triple);
     RDFVarTriple cptriple;
@@ -52,31 +129,145 @@ void BasicPattern::add(const TriplePattern& triple) {
             cvars_ += x;
             cptriple[i] = x->cp();
         } else {
-            cptriple[i] = new cp::RDFVar(query_->solver(),
-                                         v.valueId(), v.valueId());
+            cptriple[i] = nullptr; // constants get no solver variable
         }
     }
     cptriples_.push_back(cptriple);
 }
 
+Pattern* BasicPattern::optimize() {
+    // Split the triple patterns into connected components (sharing
+    // variables). Searching them in a single subtree would explore their
+    // cross product, whereas a join of independent patterns can be
+    // materialized or counted separately.
+    std::vector<unsigned> component(triples_.size());
+    std::vector<int> firstTriple(query_->variables().size(), -1);
+    std::function<unsigned(unsigned)> find = [&](unsigned i) {
+        while(component[i] != i)
+            i = component[i] = component[component[i]];
+        return i;
+    };
+    for(unsigned i = 0; i < triples_.size(); i++) {
+        component[i] = i;
+        for(int j = 0; j < TriplePattern::COMPONENTS; j++) {
+            if(!triples_[i][j].isVariable())
+                continue;
+            int& first = firstTriple[triples_[i][j].variableId()];
+            if(first < 0)
+                first = i;
+            else
+                component[find(i)] = find(first);
+        }
+    }
+    std::vector<BasicPattern*> parts;
+    std::vector<int> partOf(triples_.size(), -1);
+    std::vector<TriplePattern> ground;
+    for(unsigned i = 0; i < triples_.size(); i++) {
+        const TriplePattern& t = triples_[i];
+        if(!t[0].isVariable() && !t[1].isVariable() && !t[2].isVariable()) {
+            ground.push_back(t);
+            continue;
+        }
+        int& part = partOf[find(i)];
+        if(part < 0) {
+            part = parts.size();
+            parts.push_back(new BasicPattern(query_));
+        }
+        parts[part]->add(t);
+    }
+    if(parts.size() <= 1) {
+        for(BasicPattern* part : parts)
+            delete part;
+        return this;
+    }
+    // most selective components first
+    std::vector<std::pair<double, BasicPattern*>> sorted;
+    for(BasicPattern* part : parts)
+        sorted.emplace_back(part->cardinality(), part);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const std::pair<double, BasicPattern*>& a,
+                        const std::pair<double, BasicPattern*>& b) {
+                         return a.first < b.first;
+                     });
+    for(const TriplePattern& t : ground)
+        sorted[0].second->add(t);
+    Pattern* pat = sorted[0].second;
+    for(unsigned i = 1; i < sorted.size(); i++)
+        pat = new JoinPattern(pat, sorted[i].second);
+    delete this;
+    return pat;
+}
+
+void BasicPattern::project(const VariableSet& needed, bool distinct) {
+    projected_ = true;
+    distinct_ = distinct;
+    needed_ = needed;
+}
+
 void BasicPattern::init() {
+    /* Once projected, variables occurring only once in the pattern, neither
+     * observed elsewhere nor filtered, are wildcards: the triple constraints
+     * only check that some value exists for them and they are never labeled.
+     */
+    VariableSet wildcards(query_);
+    if(projected_) {
+        std::vector<unsigned> occurrences(query_->variables().size(), 0);
+        for(const TriplePattern& t : triples_) {
+            for(int i = 0; i < t.COMPONENTS; i++) {
+                if(t[i].isVariable())
+                    ++occurrences[t[i].variableId()];
+            }
+        }
+        std::vector<cp::DecisionVariable*> projected;
+        for(Variable* x : vars_) {
+            if(needed_.contains(x))
+                projected.push_back(x->cp());
+            else if(!filtered_.contains(x) && occurrences[x->id()] == 1)
+                wildcards += x;
+        }
+        if(distinct_)
+            sub_.project(projected);
+    }
     for(Variable* x : vars_) {
+        if(wildcards.contains(x))
+            continue;
         sub_.add(x->cp());
-        sub_.add(new BoundConstraint(query_, x->cp()));
+        sub_.add(query_->solver()->make<BoundConstraint>(query_, x->cp()));
     }
-    for(RDFVarTriple& t : cptriples_) {
+    for(unsigned i = 0; i < triples_.size(); i++) {
+        RDFVarTriple t = cptriples_[i];
+        Triple constants = constantsOf(triples_[i]);
+        bool wildcard = false;
+        for(int j = 0; j < t.COMPONENTS; j++) {
+            if(t[j] && wildcards.contains(query_->variable(triples_[i][j]))) {
+                t[j] = nullptr;
+                wildcard = true;
+            }
+        }
+        if(wildcard)
+            wildtriples_.emplace_back(t, constants);
 #if CASTOR_TRIPLEPROPAG == CASTOR_TRIPLEPROPAG_dc
-        sub_.add(new STRTripleConstraint(query_, t));
+        cp::Constraint* c = query_->solver()->make<CTTripleConstraint>(
+                    query_, t, constants);
 #else
-        sub_.add(new FCTripleConstraint(query_, t));
-#if CASTOR_TRIPLEPROPAG == CASTOR_TRIPLEPROPAG_fcplus
-        sub_.add(new ExtraTripleConstraint(query_, t));
+        cp::Constraint* c = makeFCTripleConstraint(query_, t, constants);
 #endif
+        sub_.add(c);
+        query_->attribute(c, triples_[i]);
+#if CASTOR_TRIPLEPROPAG == CASTOR_TRIPLEPROPAG_fcplus
+        // with a wildcard, forward checking is already as strong
+        if(!wildcard) {
+            cp::Constraint* extra =
+                    query_->solver()->make<ExtraTripleConstraint>(
+                        query_, t, constants);
+            sub_.add(extra);
+            query_->attribute(extra, triples_[i]);
+        }
 #endif
     }
 }
 
-bool BasicPattern::next() {
+bool BasicPattern::search() {
     if(!sub_.isActive())
         sub_.activate();
     else if(!sub_.isCurrent())
@@ -89,6 +280,76 @@ void BasicPattern::discard() {
         sub_.discard();
 }
 
+unsigned long BasicPattern::multiplicity() {
+    // Every combination of values for the wildcards is a solution. They occur
+    // in a single triple pattern, which can be counted independently.
+    unsigned long n = 1;
+    for(const auto& wild : wildtriples_) {
+        const RDFVarTriple& t = wild.first;
+        Triple pattern = wild.second;
+        for(int i = 0; i < t.COMPONENTS; i++) {
+            if(t[i])
+                pattern[i] = t[i]->value();
+        }
+        n *= query_->store()->triplesCount(pattern);
+    }
+    return n;
+}
+
+Triple BasicPattern::constantsOf(const TriplePattern& t) {
+    Triple constants;
+    for(int i = 0; i < t.COMPONENTS; i++)
+        constants[i] = t[i].isVariable() ? 0 : t[i].valueId();
+    return constants;
+}
+
+double BasicPattern::cardinality() {
+    // each triple pattern is an upper bound
+    double result = -1;
+    for(const TriplePattern& t : triples_) {
+        double n = query_->store()->triplesCount(constantsOf(t));
+        if(result < 0 || n < result)
+            result = n;
+    }
+    return result < 0 ? 1 : result;
+}
+
+void BasicPattern::references(VariableSet& refs) const {
+    refs += vars_;
+    refs += filtered_;
+}
+
+void BasicPattern::explain(std::ostream& out, int indent) {
+    explainNode(out, indent, "BasicPattern");
+    Store* store = query_->store();
+    for(cp::Constraint* c : sub_.constraints()) {
+        out << ws(indent+1) << demangle(typeid(*c).name());
+        if(const TriplePattern* t = query_->attributed(c)) {
+            // index and number of triples of the initial scan
+            Triple from, to;
+            for(int i = 0; i < t->COMPONENTS; i++) {
+                if((*t)[i].isVariable()) {
+                    from[i] = 0;
+                    to[i] = store->valuesCount();
+                } else {
+                    from[i] = to[i] = (*t)[i].valueId();
+                }
+            }
+            out << " " << query_->describe(*t)
+                << " (index: "
+                << TRIPLE_ORDER_NAMES[static_cast<int>(
+                                      Store::chooseOrder(from, to))]
+                << ", triples: " << store->triplesCount(from) << ")";
+        }
+        if(query_->solver()->profiling()) {
+            out << " [calls: " << c->statCalls() << ", time: ";
+            writeTime(out, c->statTime());
+            out << "]";
+        }
+        out << std::endl;
+    }
+}
+
 FilterPattern::FilterPattern(Pattern* subpattern, Expression* condition) :
         Pattern(subpattern->query()),
         subpattern_(subpattern), condition_(condition) {
@@ -132,52 +393,161 @@ Pattern* FilterPattern::optimize() {
     return this;
 }
 
-void FilterPattern::init() {
-    subpattern_->init();
+void FilterPattern::project(const VariableSet& needed, bool distinct) {
 #ifndef CASTOR_NOFILTERS
     if(BasicPattern* subpat = dynamic_cast<BasicPattern*>(subpattern_)) {
-        cp::TriStateVar* b = new cp::TriStateVar(query_->solver(), RDF_TRUE);
-        query_->solver()->collect(b);
-        condition_->post(subpat->sub_, b);
+        // the condition is posted in the same subtree
+        subpat->filtered_ += condition_->variables();
+        subpattern_->project(needed, distinct);
+        return;
     }
 #endif
+    VariableSet vars(needed);
+    vars += condition_->variables();
+    subpattern_->project(vars, distinct);
 }
 
-bool FilterPattern::next() {
-#ifndef CASTOR_NOFILTERS
-    if(dynamic_cast<BasicPattern*>(subpattern_)) {
-        return subpattern_->next();
+namespace {
+
+/**
+ * Split a condition into its conjuncts.
+ *
+ * @param expr the condition
+ * @param[out] result vector to which the conjuncts are appended
+ */
+void conjuncts(Expression* expr, std::vector<Expression*>& result) {
+    if(AndExpression* conj = dynamic_cast<AndExpression*>(expr)) {
+        conjuncts(conj->left(), result);
+        conjuncts(conj->right(), result);
     } else {
+        result.push_back(expr);
+    }
+}
+
+}
+
+void FilterPattern::init() {
+    subpattern_->init();
+    residual_.clear();
+#ifdef CASTOR_NOFILTERS
+    residual_.push_back(condition_);
+#else
+    if(BasicPattern* subpat = dynamic_cast<BasicPattern*>(subpattern_)) {
+        cp::Solver* solver = query_->solver();
+        cp::TriStateVar* b = solver->make<cp::TriStateVar>(solver, RDF_TRUE);
+        condition_->post(subpat->sub_, b);
+    } else {
+        // push each conjunct down to the basic patterns binding its variables
+        std::vector<Expression*> conds;
+        conjuncts(condition_, conds);
+        VariableSet bound(query_);
+        for(Expression* cond : conds) {
+            if(!post(subpattern_, cond, bound))
+                residual_.push_back(cond);
+        }
+    }
 #endif
-        while(subpattern_->next()) {
-            for(Variable* x : condition_->variables())
+}
+
+bool FilterPattern::post(Pattern* pat, Expression* cond,
+                         const VariableSet& bound) {
+    if(BasicPattern* p = dynamic_cast<BasicPattern*>(pat)) {
+        VariableSet avail(bound);
+        avail += p->certainVars();
+        if((cond->variables() * avail).size() != cond->variables().size())
+            return false;
+        p->filtered_ += cond->variables();
+        Query* query = p->query();
+        cp::Solver* solver = query->solver();
+        cp::TriStateVar* b = solver->make<cp::TriStateVar>(solver, RDF_TRUE);
+        cond->post(p->sub_, b);
+        return true;
+    } else if(FilterPattern* p = dynamic_cast<FilterPattern*>(pat)) {
+        return post(p->subpattern_, cond, bound);
+    } else if(JoinPattern* p = dynamic_cast<JoinPattern*>(pat)) {
+        if(post(p->left(), cond, bound))
+            return true;
+        // the right subpattern is searched once the left one is bound
+        VariableSet leftBound(bound);
+        leftBound += p->left()->certainVars();
+        return post(p->right(), cond, leftBound);
+    } else if(UnionPattern* p = dynamic_cast<UnionPattern*>(pat)) {
+        bool left = post(p->left(), cond, bound);
+        bool right = post(p->right(), cond, bound);
+        return left && right;
+    } else if(CompoundPattern* p = dynamic_cast<CompoundPattern*>(pat)) {
+        // LeftJoin and Diff: the solutions extend those of the left part
+        return post(p->left(), cond, bound);
+    }
+    return false;
+}
+
+bool FilterPattern::search() {
+    while(subpattern_->next()) {
+        bool satisfied = true;
+        for(Expression* cond : residual_) {
+            for(Variable* x : cond->variables())
                 x->setFromCP();
-            if(condition_->isTrue())
-                return true;
+            if(!cond->isTrue()) {
+                satisfied = false;
+                break;
+            }
         }
-        return false;
-#ifndef CASTOR_NOFILTERS
+        if(satisfied)
+            return true;
     }
-#endif
+    return false;
 }
 
 void FilterPattern::discard() {
     subpattern_->discard();
 }
 
+void FilterPattern::references(VariableSet& refs) const {
+    subpattern_->references(refs);
+    refs += condition_->variables();
+}
+
+void FilterPattern::analyze(bool enable) {
+    Pattern::analyze(enable);
+    subpattern_->analyze(enable);
+}
+
+void FilterPattern::explain(std::ostream& out, int indent) {
+    std::ostringstream name;
+    name << "FilterPattern(" << residual_.size() << " residual conditions)";
+    explainNode(out, indent, name.str());
+    subpattern_->explain(out, indent+1);
+}
+
 CompoundPattern::CompoundPattern(Pattern* left, Pattern* right) :
-        Pattern(left->query()), left_(left), right_(right) {}
+        Pattern(left->query()), left_(left), right_(right),
+        cache_(nullptr), replay_(nullptr), projected_(false),
+        needed_(left->query()), memo_(false), existence_(false),
+        prepared_(false), running_(false) {}
 
-CompoundPattern::CompoundPattern(CompoundPattern&& o) : Pattern(o.query()) {
+CompoundPattern::CompoundPattern(CompoundPattern&& o) :
+        Pattern(o.query()), needed_(o.needed_) {
     left_    = o.left_;
     right_   = o.right_;
+    cache_   = o.cache_;
+    replay_  = o.replay_;
+    projected_ = o.projected_;
+    memo_    = o.memo_;
+    existence_ = o.existence_;
+    prepared_ = o.prepared_;
+    running_ = o.running_;
     o.left_  = nullptr;
     o.right_ = nullptr;
+    o.cache_ = nullptr;
+    o.replay_ = nullptr;
 }
 
 CompoundPattern::~CompoundPattern() {
     delete left_;
     delete right_;
+    delete cache_;
+    delete replay_;
 }
 
 Pattern* CompoundPattern::optimize() {
@@ -186,11 +556,174 @@ Pattern* CompoundPattern::optimize() {
     return this;
 }
 
+void CompoundPattern::project(const VariableSet& needed, bool distinct) {
+    projected_ = true;
+    needed_ = needed;
+    VariableSet leftNeeded(needed);
+    leftNeeded += right_->variables();
+    VariableSet rightNeeded(needed);
+    rightNeeded += left_->variables();
+    left_->project(leftNeeded, distinct);
+    right_->project(rightNeeded, distinct);
+}
+
 void CompoundPattern::init() {
     left_->init();
     right_->init();
 }
 
+void CompoundPattern::references(VariableSet& refs) const {
+    left_->references(refs);
+    right_->references(refs);
+}
+
+void CompoundPattern::analyze(bool enable) {
+    Pattern::analyze(enable);
+    left_->analyze(enable);
+    right_->analyze(enable);
+}
+
+void CompoundPattern::explain(std::ostream& out, int indent) {
+    std::string name = demangle(typeid(*this).name());
+    name = name.substr(name.rfind(':') + 1);
+    // the physical operator is chosen on the first activation
+    if(prepared_) {
+        if(cache_ == nullptr)
+            name += "(nested loops)";
+        else if(memo_)
+            name += "(memo)";
+        else
+            name += "(hash join)";
+    }
+    explainNode(out, indent, name);
+    left_->explain(out, indent+1);
+    right_->explain(out, indent+1);
+}
+
+bool CompoundPattern::prepareHashJoin() {
+    VariableSet refs(query_);
+    right_->references(refs);
+    VariableSet keys = refs * left_->variables();
+    // the right solutions must not depend on optional left variables
+    if((keys * left_->certainVars() * right_->certainVars()).size() !=
+            keys.size())
+        return false;
+    double card = right_->cardinality();
+    if(card > HASH_JOIN_MAX_CARDINALITY ||
+       (keys.size() > 0 && card >= left_->cardinality()))
+        return false;
+    std::vector<Variable*> keyVars(keys.begin(), keys.begin() + keys.size());
+    std::vector<Variable*> rowVars = rowVariables(keys);
+    cache_ = new RowCache(keyVars, rowVars, ROW_CACHE_BUDGET);
+    replay_ = new RowReplay(query_, rowVars);
+    return true;
+}
+
+void CompoundPattern::prepareMemo(bool existence) {
+    VariableSet refs(query_);
+    right_->references(refs);
+    VariableSet keys = refs * left_->variables();
+    if((keys * left_->certainVars()).size() != keys.size())
+        return; // the key may be incomplete
+    if(keys.size() == left_->variables().size())
+        return; // each left solution has its own key
+    std::vector<Variable*> keyVars(keys.begin(), keys.begin() + keys.size());
+    std::vector<Variable*> rowVars;
+    if(!existence)
+        rowVars = rowVariables(keys);
+    cache_ = new RowCache(keyVars, rowVars, ROW_CACHE_BUDGET);
+    replay_ = new RowReplay(query_, rowVars);
+    memo_ = true;
+    existence_ = existence;
+}
+
+std::vector<Variable*> CompoundPattern::rowVariables(const VariableSet& keys) {
+    std::vector<Variable*> result;
+    for(Variable* x : right_->variables()) {
+        if(!keys.contains(x) && (!projected_ || needed_.contains(x)))
+            result.push_back(x);
+    }
+    return result;
+}
+
+void CompoundPattern::build() {
+    if(!prepared_) {
+        prepared_ = true;
+        prepare();
+    }
+    running_ = true;
+    if(!cache_)
+        return;
+    // The right subpattern may depend on variables bound by enclosing
+    // patterns: the cache is only valid during one activation.
+    cache_->clear();
+    if(memo_)
+        return; // filled lazily by nextRight()
+    while(right_->next()) {
+        RowCache::Rows* rows = cache_->insert(cache_->currentKey());
+        if(!cache_->append(rows, right_->multiplicity())) {
+            // over budget: fall back to nested loops
+            right_->discard();
+            dropCache();
+            return;
+        }
+    }
+}
+
+RowCache::Rows* CompoundPattern::record(const RowCache::Key& key) {
+    RowCache::Rows* rows = cache_->insert(key);
+    while(right_->next()) {
+        if(!cache_->append(rows, right_->multiplicity())) {
+            // over budget: fall back to nested loops
+            right_->discard();
+            dropCache();
+            return nullptr;
+        }
+        if(existence_) {
+            right_->discard();
+            break;
+        }
+    }
+    return rows;
+}
+
+void CompoundPattern::dropCache() {
+    delete cache_;
+    delete replay_;
+    cache_ = nullptr;
+    replay_ = nullptr;
+    memo_ = false;
+}
+
+bool CompoundPattern::nextRight() {
+    if(cache_ && !replay_->isReplaying()) {
+        const RowCache::Key& key = cache_->currentKey();
+        RowCache::Rows* rows = cache_->find(key);
+        if(!rows && memo_)
+            rows = record(key);
+        if(cache_)
+            replay_->replay(rows);
+    }
+    if(!cache_)
+        return right_->next();
+    return replay_->next();
+}
+
+void CompoundPattern::discardRight() {
+    if(cache_) {
+        replay_->discard();
+        // the right subpattern is only active if filling the cache has been
+        // aborted
+        right_->discard();
+    } else {
+        right_->discard();
+    }
+}
+
+unsigned long CompoundPattern::rightMultiplicity() {
+    return cache_ ? replay_->multiplicity() : right_->multiplicity();
+}
+
 void JoinPattern::initialize() {
     vars_ = left_->variables();
     vars_ += right_->variables();
@@ -201,11 +734,14 @@ void JoinPattern::initialize() {
 Pattern* JoinPattern::optimize() {
     left_ = left_->optimize();
     right_ = right_->optimize();
-    // Join(BGP, BGP) -> BGP
+    // Join(BGP, BGP) -> BGP, unless they are independent (see
+    // BasicPattern::optimize())
     BasicPattern* bleft;
     BasicPattern* bright;
     if((bleft = dynamic_cast<BasicPattern*>(left_)) &&
-       (bright = dynamic_cast<BasicPattern*>(right_))) {
+       (bright = dynamic_cast<BasicPattern*>(right_)) &&
+       (bleft->variables().size() == 0 || bright->variables().size() == 0 ||
+        (bleft->variables() * bright->variables()).size() > 0)) {
         BasicPattern* pat = new BasicPattern(query_);
         for(TriplePattern t : *bleft)
             pat->add(t);
@@ -217,16 +753,29 @@ Pattern* JoinPattern::optimize() {
     return this;
 }
 
-bool JoinPattern::next() {
+double JoinPattern::cardinality() {
+    double left = left_->cardinality();
+    double right = right_->cardinality();
+    if((left_->variables() * right_->variables()).size() > 0)
+        return std::max(left, right);
+    else
+        return left * right;
+}
+
+bool JoinPattern::search() {
+    if(!running_)
+        build();
     while(left_->next())
-        if(right_->next())
+        if(nextRight())
             return true;
+    running_ = false;
     return false;
 }
 
 void JoinPattern::discard() {
-    right_->discard();
+    discardRight();
     left_->discard();
+    running_ = false;
 }
 
 void LeftJoinPattern::initialize() {
@@ -236,9 +785,32 @@ void LeftJoinPattern::initialize() {
     consistent_ = false;
 }
 
-bool LeftJoinPattern::next() {
+Pattern* LeftJoinPattern::optimize() {
+    left_ = left_->optimize();
+    right_ = right_->optimize();
+    // LeftJoin(LeftJoin(A, B), C) = LeftJoin(LeftJoin(A, C), B) if B and C
+    // only depend on each other through variables bound by A. Evaluate the
+    // most selective optional part first.
+    LeftJoinPattern* inner = dynamic_cast<LeftJoinPattern*>(left_);
+    if(inner) {
+        VariableSet refsB(query_), refsC(query_);
+        inner->right_->references(refsB);
+        right_->references(refsC);
+        VariableSet shared = refsB * refsC;
+        if((shared * inner->left_->certainVars()).size() == shared.size() &&
+           right_->cardinality() < inner->right_->cardinality()) {
+            std::swap(inner->right_, right_);
+            inner->initialize();
+        }
+    }
+    return this;
+}
+
+bool LeftJoinPattern::search() {
+    if(!running_)
+        build();
     while(left_->next()) {
-        if(right_->next()) {
+        if(nextRight()) {
             consistent_ = true;
             return true;
         } else if(!consistent_) {
@@ -247,13 +819,15 @@ bool LeftJoinPattern::next() {
             consistent_ = false;
         }
     }
+    running_ = false;
     return false;
 }
 
 void LeftJoinPattern::discard() {
-    right_->discard();
+    discardRight();
     left_->discard();
     consistent_ = false;
+    running_ = false;
 }
 
 void DiffPattern::initialize() {
@@ -261,19 +835,31 @@ void DiffPattern::initialize() {
     cvars_ = left_->certainVars();
 }
 
-bool DiffPattern::next() {
+void DiffPattern::project(const VariableSet& needed, bool distinct) {
+    VariableSet leftNeeded(needed);
+    leftNeeded += right_->variables();
+    left_->project(leftNeeded, distinct);
+    // only the existence of a solution matters in the right pattern
+    right_->project(left_->variables(), true);
+}
+
+bool DiffPattern::search() {
+    if(!running_)
+        build();
     while(left_->next()) {
-        if(right_->next())
-            right_->discard();
+        if(nextRight())
+            discardRight();
         else
             return true;
     }
+    running_ = false;
     return false;
 }
 
 void DiffPattern::discard() {
-    right_->discard();
+    discardRight();
     left_->discard();
+    running_ = false;
 }
 
 void UnionPattern::initialize() {
@@ -283,7 +869,21 @@ void UnionPattern::initialize() {
     onRightBranch_ = false;
 }
 
-bool UnionPattern::next() {
+Pattern* UnionPattern::optimize() {
+    left_ = left_->optimize();
+    right_ = right_->optimize();
+    // most selective branch first
+    if(right_->cardinality() < left_->cardinality())
+        std::swap(left_, right_);
+    return this;
+}
+
+void UnionPattern::project(const VariableSet& needed, bool distinct) {
+    left_->project(needed, distinct);
+    right_->project(needed, distinct);
+}
+
+bool UnionPattern::search() {
     if(!onRightBranch_ && left_->next())
         return true;
     onRightBranch_ = true;
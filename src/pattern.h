@@ -19,12 +19,15 @@
 #define CASTOR_PATTERN_H
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include <typeinfo>
 
 #include "solver/subtree.h"
+#include "store.h"
 #include "variable.h"
 #include "expression.h"
+#include "rowcache.h"
 
 namespace castor {
 
@@ -35,7 +38,23 @@ class Query;
  */
 class Pattern {
 public:
-    Pattern(Query* query) : query_(query), vars_(query), cvars_(query) {}
+    /**
+     * Statistics gathered while analyzing a pattern. They include those of
+     * the subpatterns.
+     */
+    struct Stats {
+        unsigned long calls;       //!< calls to next()
+        unsigned long solutions;   //!< solutions found
+        unsigned long backtracks;  //!< backtracks of the solver
+        unsigned long propagate;   //!< calls to propagators
+        unsigned long triples;     //!< triples scanned
+        unsigned long cacheHits;   //!< triple cache hits
+        unsigned long cacheMisses; //!< triple cache misses
+        unsigned long long time;   //!< time spent in next(), in nanoseconds
+    };
+
+    Pattern(Query* query) : query_(query), vars_(query), cvars_(query),
+        analyzing_(false), stats_() {}
     virtual ~Pattern() {}
 
     //! Non-copyable
@@ -66,6 +85,41 @@ public:
      */
     virtual Pattern* optimize() { return this; }
 
+    /**
+     * Tell this pattern which of its variables are observed by the rest of
+     * the query. Variables that are only needed to prove the existence of a
+     * solution need not be labeled: a solution then stands for
+     * multiplicity() solutions of the pattern. If distinct is true, only
+     * distinct assignments of the observed variables are of interest and
+     * solutions differing only on the other variables may be skipped. Must be
+     * called before init(), if at all.
+     *
+     * @param needed the observed variables
+     * @param distinct whether duplicate solutions may be skipped
+     */
+    virtual void project(const VariableSet& needed, bool distinct) {}
+
+    /**
+     * @return the number of solutions of the pattern the current solution
+     *         stands for (see project())
+     */
+    virtual unsigned long multiplicity() { return 1; }
+
+    /**
+     * @return a rough estimate of the number of solutions of this pattern,
+     *         based on the triple counts of the store
+     */
+    virtual double cardinality() = 0;
+
+    /**
+     * Add the variables whose values may restrict the solutions of this
+     * pattern, i.e., its variables and those of the filters posted in it.
+     * Only meaningful after init().
+     *
+     * @param[out] refs set to which the variables are added
+     */
+    virtual void references(VariableSet& refs) const { refs += vars_; }
+
     /**
      * Initialize subtree recursively.
      */
@@ -75,7 +129,7 @@ public:
      * Find the next solution of the subtree
      * @return false if there are no more solution, true otherwise
      */
-    virtual bool next() = 0;
+    bool next() { return analyzing_ ? analyzedNext() : search(); }
 
     /**
      * Discard the rest of the subtree's solutions.
@@ -94,7 +148,45 @@ public:
      */
     virtual void print(std::ostream& out, int indent) const = 0;
 
+    /**
+     * Enable or disable the gathering of statistics in this pattern and its
+     * subpatterns. Enabling it resets the statistics.
+     *
+     * @param enable true to enable analysis, false to disable it
+     */
+    virtual void analyze(bool enable);
+
+    /**
+     * @return the statistics gathered while analyzing
+     */
+    const Stats& stats() const { return stats_; }
+
+    /**
+     * Write the execution plan of this pattern and its subpatterns, with
+     * the statistics gathered if analyzing.
+     *
+     * @param out output stream
+     * @param indent indent level
+     */
+    virtual void explain(std::ostream& out, int indent) = 0;
+
 protected:
+    /**
+     * Find the next solution of the subtree. Implementation of next().
+     * @return false if there are no more solution, true otherwise
+     */
+    virtual bool search() = 0;
+
+    /**
+     * Write the line describing this node in the execution plan: its name,
+     * cardinality estimate and, if analyzing, statistics.
+     *
+     * @param out output stream
+     * @param indent indent level
+     * @param name name of the node
+     */
+    void explainNode(std::ostream& out, int indent, const std::string& name);
+
     /**
      * Parent query
      */
@@ -115,6 +207,15 @@ protected:
      * @param indent indent level
      */
     std::string ws(int indent) const { return std::string(2*indent, ' '); }
+
+private:
+    /**
+     * Call search() and update the statistics.
+     */
+    bool analyzedNext();
+
+    bool  analyzing_; //!< are statistics gathered?
+    Stats stats_;     //!< statistics gathered while analyzing
 };
 
 std::ostream& operator<<(std::ostream& out, const Pattern& p);
@@ -127,11 +228,17 @@ class FalsePattern : public Pattern {
 public:
     FalsePattern(Query* query) : Pattern(query) {}
     void init() override {}
-    bool next() override { return false; }
     void discard() override {}
+    double cardinality() override { return 0; }
     void print(std::ostream& out, int indent) const override {
         out << ws(indent) << "FalsePattern";
     }
+    void explain(std::ostream& out, int indent) override {
+        explainNode(out, indent, "FalsePattern");
+    }
+
+protected:
+    bool search() override { return false; }
 };
 
 typedef BasicTriple<VarVal> TriplePattern;
@@ -143,7 +250,6 @@ typedef BasicTriple<cp::RDFVar*> RDFVarTriple;
 class BasicPattern : public Pattern {
 public:
     BasicPattern(Query* query);
-    ~BasicPattern();
 
     /**
      * Add a triple pattern
@@ -151,21 +257,46 @@ public:
      */
     void add(const TriplePattern& triple);
 
+    Pattern* optimize() override;
+    void project(const VariableSet& needed, bool distinct) override;
     void init() override;
-    bool next() override;
     void discard() override;
+    unsigned long multiplicity() override;
+    double cardinality() override;
+    void references(VariableSet& refs) const override;
 
     void print(std::ostream& out, int indent) const override {
         out << ws(indent) << "BasicPattern(" << triples_.size() << " triples)";
     }
+    void explain(std::ostream& out, int indent) override;
 
     std::vector<TriplePattern>::const_iterator begin() const { return triples_.cbegin(); }
     std::vector<TriplePattern>::const_iterator end() const { return triples_.cend(); }
 
+protected:
+    bool search() override;
+
 private:
+    /**
+     * @param t a triple pattern
+     * @return the values of the constant components of t (0 otherwise)
+     */
+    static Triple constantsOf(const TriplePattern& t);
+
     std::vector<TriplePattern> triples_;
+    /**
+     * Solver variables of the triple patterns (nullptr for constants)
+     */
     std::vector<RDFVarTriple>  cptriples_;
     cp::Subtree                sub_;
+    bool                       projected_; //!< has project() been called?
+    bool                       distinct_;  //!< may duplicates be skipped?
+    VariableSet                needed_;    //!< observed variables
+    VariableSet                filtered_;  //!< variables of posted filters
+    /**
+     * Triple patterns with wildcard components, with their constants
+     */
+    std::vector<std::pair<RDFVarTriple, Triple>> wildtriples_;
 
     friend class FilterPattern;
 };
@@ -189,19 +320,39 @@ public:
     Expression* condition() { return condition_; }
 
     Pattern* optimize() override;
+    void project(const VariableSet& needed, bool distinct) override;
     void init() override;
-    bool next() override;
     void discard() override;
+    unsigned long multiplicity() override { return subpattern_->multiplicity(); }
+    double cardinality() override { return subpattern_->cardinality(); }
+    void references(VariableSet& refs) const override;
 
     void print(std::ostream& out, int indent) const override {
         out << ws(indent) << "FilterPattern("
             << vars_.size() << " variables)" << std::endl;
         subpattern_->print(out, indent+1);
     }
+    void analyze(bool enable) override;
+    void explain(std::ostream& out, int indent) override;
+
+protected:
+    bool search() override;
 
 private:
+    /**
+     * Post a conjunct of the condition in the basic patterns within pat in
+     * which all its variables are certainly bound.
+     *
+     * @param pat the pattern
+     * @param cond the conjunct
+     * @param bound variables certainly bound before pat is searched
+     * @return whether all solutions of pat satisfy cond
+     */
+    static bool post(Pattern* pat, Expression* cond, const VariableSet& bound);
+
     Pattern*    subpattern_;
     Expression* condition_;
+    std::vector<Expression*> residual_; //!< conjuncts checked on the solutions
 };
 
 /**
@@ -225,17 +376,105 @@ public:
     Pattern* right() { return right_; }
 
     Pattern* optimize() override;
+    void project(const VariableSet& needed, bool distinct) override;
     void init() override;
+    double cardinality() override { return left_->cardinality(); }
+    void references(VariableSet& refs) const override;
 
     void print(std::ostream& out, int indent) const override {
         out << ws(indent) << typeid(*this).name() << std::endl;
         left_->print(out, indent+1); out << std::endl;
         right_->print(out, indent+1);
     }
+    void analyze(bool enable) override;
+    void explain(std::ostream& out, int indent) override;
 
 protected:
+    /**
+     * Choose the physical operator on the first activation. The default is
+     * nested loops.
+     */
+    virtual void prepare() {}
+
+    /**
+     * Use a hash join if possible: the solutions of the right subpattern are
+     * materialized in a hash table keyed on the variables shared with the
+     * left subpattern instead of searching the right subpattern again for
+     * each left solution. This is the case if the key variables are bound in
+     * both subpatterns and the right subpattern is estimated to be smaller
+     * than the left one, or if both subpatterns are independent (empty key):
+     * the right solutions are then computed once and combined with every
+     * left solution.
+     *
+     * @return whether a hash join is used
+     */
+    bool prepareHashJoin();
+
+    /**
+     * Memoize the solutions of the right subpattern for each tuple of values
+     * of the shared variables, if the left subpattern may produce several
+     * solutions agreeing on them.
+     *
+     * @param existence whether only the existence of a solution matters
+     */
+    void prepareMemo(bool existence);
+
+    /**
+     * Start a new activation: materialize the right subpattern if a hash
+     * join is used, clear the memoized solutions otherwise. Falls back to
+     * nested loops if the memory budget is exceeded.
+     */
+    void build();
+
+    /**
+     * Find the next solution of the right subpattern compatible with the
+     * current left solution.
+     *
+     * @return false if there are no more solutions, true otherwise
+     */
+    bool nextRight();
+
+    /**
+     * Discard the rest of the right subpattern's solutions.
+     */
+    void discardRight();
+
+    /**
+     * @return the multiplicity of the current right solution
+     */
+    unsigned long rightMultiplicity();
+
     Pattern* left_;
     Pattern* right_;
+    RowCache*  cache_;  //!< materialized right solutions (nullptr if unused)
+    RowReplay* replay_; //!< replay of the cached right solutions
+    bool projected_; //!< has project() been called?
+    VariableSet needed_; //!< observed variables
+    bool memo_;      //!< is cache_ filled lazily for each key?
+    bool existence_; //!< memoize only the existence of right solutions?
+    bool prepared_;  //!< has prepare() been called?
+    bool running_;   //!< is the pattern active?
+
+private:
+    /**
+     * Record the right solutions for the current key in the memo.
+     *
+     * @param key the current key
+     * @return the recorded rows or nullptr if the budget was exceeded
+     */
+    RowCache::Rows* record(const RowCache::Key& key);
+
+    /**
+     * @param keys the key variables
+     * @return the variables of the right subpattern to store in the cache:
+     *         the observed ones that are not part of the key
+     */
+    std::vector<Variable*> rowVariables(const VariableSet& keys);
+
+    /**
+     * Stop using cache_ and revert to nested loops.
+     */
+    void dropCache();
 };
 
 /**
@@ -250,11 +489,16 @@ public:
         initialize();
     }
     Pattern* optimize() override;
-    bool next() override;
     void discard() override;
+    unsigned long multiplicity() override {
+        return left_->multiplicity() * rightMultiplicity();
+    }
+    double cardinality() override;
 
 protected:
+    bool search() override;
     void initialize();
+    void prepare() override { prepareHashJoin(); }
 };
 
 /**
@@ -268,11 +512,20 @@ public:
     LeftJoinPattern(CompoundPattern&& o) : CompoundPattern(std::move(o)) {
         initialize();
     }
-    bool next() override;
+    Pattern* optimize() override;
     void discard() override;
+    unsigned long multiplicity() override {
+        return consistent_ ? left_->multiplicity() * rightMultiplicity()
+                           : left_->multiplicity();
+    }
 
 protected:
+    bool search() override;
     void initialize();
+    void prepare() override {
+        if(!prepareHashJoin())
+            prepareMemo(false);
+    }
 
 private:
     bool consistent_; //!< is the right branch consistent?
@@ -289,11 +542,14 @@ public:
     DiffPattern(CompoundPattern&& o) : CompoundPattern(std::move(o)) {
         initialize();
     }
-    bool next() override;
+    void project(const VariableSet& needed, bool distinct) override;
     void discard() override;
+    unsigned long multiplicity() override { return left_->multiplicity(); }
 
 protected:
+    bool search() override;
     void initialize();
+    void prepare() override { prepareMemo(true); }
 };
 
 /**
@@ -307,10 +563,18 @@ public:
     UnionPattern(CompoundPattern&& o) : CompoundPattern(std::move(o)) {
         initialize();
     }
-    bool next() override;
+    Pattern* optimize() override;
+    void project(const VariableSet& needed, bool distinct) override;
     void discard() override;
+    unsigned long multiplicity() override {
+        return onRightBranch_ ? right_->multiplicity() : left_->multiplicity();
+    }
+    double cardinality() override {
+        return left_->cardinality() + right_->cardinality();
+    }
 
 protected:
+    bool search() override;
     void initialize();
 
 private:
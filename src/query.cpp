@@ -18,7 +18,10 @@
 #include "query.h"
 
 #include <cassert>
+#include <algorithm>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "pattern.h"
 #include "expression.h"
@@ -47,8 +50,12 @@ void Solution::restore() const {
 bool Solution::operator<(const Solution& o) const {
     assert(o.query_ == query_);
     const Solution& t = *this;
+    Value::id_t maxId = query_->store()->valuesCount();
     for(Order order : query_->orders()) {
-        if(VariableExpression* varexpr = dynamic_cast<VariableExpression*>(order.expression())) {
+        VariableExpression* varexpr = dynamic_cast<VariableExpression*>(order.expression());
+        if(varexpr && t[varexpr->variable()] <= maxId &&
+                      o[varexpr->variable()] <= maxId) {
+            // ids from the store follow the order of the values
             Variable* x = varexpr->variable();
             if(t[x] != o[x])
                 return order.isDescending() ? t[x] > o[x] : t[x] < o[x];
@@ -67,11 +74,13 @@ bool Solution::operator<(const Solution& o) const {
     return false;
 }
 
-Query::Query(Store* store, const char* queryString) : store_(store) {
+Query::Query(Store* store, const char* queryString) :
+        store_(store), profileStart_() {
     rasqal_query* query = rasqal_new_query(librdf::World::instance().rasqal,
                                            "sparql", nullptr);
     pattern_ = nullptr;
     solutions_ = nullptr;
+    solver_.budget(&budget_);
     try {
         if(rasqal_query_prepare(query,
                                 reinterpret_cast<const unsigned char*>(queryString),
@@ -138,6 +147,62 @@ Query::Query(Store* store, const char* queryString) : store_(store) {
             vars_.push_back(x);
         }
 
+        // GROUP BY and aggregates
+        if(verb == RASQAL_QUERY_VERB_SELECT) {
+            Sequence<rasqal_expression> seqGroup =
+                    rasqal_query_get_group_conditions_sequence(query);
+            for(rasqal_expression* expr : seqGroup) {
+                if(expr->op == RASQAL_EXPR_GROUP_COND_ASC ||
+                   expr->op == RASQAL_EXPR_GROUP_COND_DESC)
+                    expr = expr->arg1;
+                if(expr->op != RASQAL_EXPR_LITERAL ||
+                   expr->literal->type != RASQAL_LITERAL_VARIABLE)
+                    throw CastorException() << "GROUP BY expects variables";
+                groupBy_.push_back(reinterpret_cast<Variable*>(
+                        expr->literal->value.variable->user_data));
+            }
+            Sequence<rasqal_expression> seqHaving =
+                    rasqal_query_get_having_conditions_sequence(query);
+            if(seqHaving.size() > 0)
+                throw CastorException() << "HAVING is not supported";
+            for(rasqal_variable* var : seqRequested) {
+                rasqal_expression* expr = var->expression;
+                if(expr == nullptr)
+                    continue;
+                if(expr->op != RASQAL_EXPR_COUNT)
+                    throw CastorException() << "Unsupported projection "
+                                               "expression op: " << expr->op;
+                bool distinct = expr->flags & RASQAL_EXPR_FLAG_DISTINCT;
+                Variable* arg;
+                if(expr->arg1->op == RASQAL_EXPR_VARSTAR) {
+                    if(distinct)
+                        throw CastorException()
+                                << "COUNT(DISTINCT *) is not supported";
+                    arg = nullptr;
+                } else if(expr->arg1->op == RASQAL_EXPR_LITERAL &&
+                          expr->arg1->literal->type == RASQAL_LITERAL_VARIABLE) {
+                    arg = reinterpret_cast<Variable*>(
+                            expr->arg1->literal->value.variable->user_data);
+                } else {
+                    throw CastorException() << "COUNT expects a variable";
+                }
+                aggregates_.emplace_back(reinterpret_cast<Variable*>(var->user_data),
+                                         arg, distinct);
+            }
+            if(isAggregate()) {
+                for(unsigned i = 0; i < requested_; i++) {
+                    bool grouped = false;
+                    for(Variable* x : groupBy_)
+                        grouped = grouped || x == vars_[i];
+                    for(const CountAggregate& a : aggregates_)
+                        grouped = grouped || a.result() == vars_[i];
+                    if(!grouped)
+                        throw CastorException() << "Variable " << *vars_[i]
+                                                << " is not grouped";
+                }
+            }
+        }
+
         // ORDERY BY expressions
         bnbOrderCstr_ = nullptr;
         if(verb == RASQAL_QUERY_VERB_SELECT) {
@@ -160,10 +225,11 @@ Query::Query(Store* store, const char* queryString) : store_(store) {
                 }
                 orders_.emplace_back(convert(expr)->optimize(), descending);
             }
-            if(!orders_.empty()) {
+            if(!orders_.empty() || isAggregate()) {
                 solutions_ = new SolutionSet;
-                if(limit_ >= 0) {
-                    bnbOrderCstr_ = new BnBOrderConstraint(this);
+                // Branch-and-Bound only applies to the solutions of the pattern
+                if(limit_ >= 0 && !isAggregate()) {
+                    bnbOrderCstr_ = solver_.make<BnBOrderConstraint>(this);
                     solver_.add(bnbOrderCstr_);
                 }
             }
@@ -172,11 +238,42 @@ Query::Query(Store* store, const char* queryString) : store_(store) {
         // graph pattern
         pattern_ = convert(rasqal_query_get_query_graph_pattern(query));
         pattern_ = pattern_->optimize();
+        replicate_ = false;
+        if(isAggregate()) {
+            // only the grouping and the counted variables are observed
+            VariableSet needed(this);
+            bool distinct = true;
+            for(Variable* x : groupBy_)
+                needed += x;
+            for(const CountAggregate& a : aggregates_) {
+                if(a.argument())
+                    needed += a.argument();
+                distinct = distinct && a.isDistinct();
+            }
+            pattern_->project(needed, distinct);
+        } else if(isDistinct() || verb == RASQAL_QUERY_VERB_ASK) {
+            // only the requested variables and the ordering are observed
+            // (none for ASK queries, where a single solution is enough)
+            VariableSet needed(this);
+            for(unsigned i = 0; i < requested_; i++)
+                needed += vars_[i];
+            for(Order order : orders_)
+                needed += order.expression()->variables();
+            pattern_->project(needed, true);
+        } else if(orders_.empty()) {
+            // only the requested variables are observed, a solution of the
+            // pattern is returned multiplicity() times
+            VariableSet needed(this);
+            for(unsigned i = 0; i < requested_; i++)
+                needed += vars_[i];
+            pattern_->project(needed, false);
+            replicate_ = true;
+        }
         pattern_->init();
 
-        // DISTINCT constraint
-        if(isDistinct()) {
-            distinctCstr_ = new DistinctConstraint(this);
+        // DISTINCT constraint (aggregated solutions are filtered afterwards)
+        if(isDistinct() && !isAggregate()) {
+            distinctCstr_ = solver_.make<DistinctConstraint>(this);
             solver_.add(distinctCstr_);
         } else {
             distinctCstr_ = nullptr;
@@ -186,6 +283,7 @@ Query::Query(Store* store, const char* queryString) : store_(store) {
         rasqal_free_query(query);
 
         nbSols_ = 0;
+        pending_ = 0;
 
     } catch(std::exception) {
         delete pattern_;
@@ -464,21 +562,27 @@ std::ostream& operator<<(std::ostream& out, const Query& q) {
 // Search
 
 bool Query::next() {
+    BudgetScope<Store> scope(*store_, &budget_);
+    if(limit_ >= 0 && nbSols_ >= static_cast<unsigned>(limit_))
+        return false;
     if(solutions_ == nullptr) {
-        if(limit_ >= 0 && nbSols_ >= static_cast<unsigned>(limit_))
+        if(nbSols_ == 0 && !skipSolutions(offset_))
             return false;
-        if(nbSols_ == 0) {
-            for(unsigned i = 0; i < offset_; i++) {
-                if(!nextPatternSolution())
-                    return false;
-            }
+        if(pending_ == 0) {
+            if(!nextPatternSolution())
+                return false;
+            pending_ = solutionMultiplicity();
         }
-        if(!nextPatternSolution())
-            return false;
+        pending_--;
         nbSols_++;
         return true;
     } else {
-        if(nbSols_ == 0) {
+        if(nbSols_ == 0 && isAggregate()) {
+            aggregate();
+            it_ = solutions_->begin();
+            for(unsigned i = 0; i < offset_ && it_ != solutions_->end(); i++)
+                ++it_;
+        } else if(nbSols_ == 0) {
             while(nextPatternSolution()) {
                 solutions_->insert(new Solution(this));
                 if(limit_ >= 0) {
@@ -519,16 +623,273 @@ bool Query::nextPatternSolution() {
     return true;
 }
 
+unsigned long Query::solutionMultiplicity() {
+    return replicate_ ? pattern_->multiplicity() : 1;
+}
+
+bool Query::skipSolutions(unsigned long n) {
+    while(n > 0) {
+        if(distinctCstr_ != nullptr) {
+            if(!nextPatternSolution())
+                return false;
+        } else if(!pattern_->next()) {
+            return false;
+        }
+        unsigned long m = solutionMultiplicity();
+        if(m > n) {
+            for(Variable* x : vars_)
+                x->setFromCP();
+            pending_ = m - n;
+            return true;
+        }
+        n -= m;
+    }
+    return true;
+}
+
+namespace {
+
+/**
+ * Hash function for grouping keys
+ */
+struct GroupKeyHash {
+    std::size_t operator()(const std::vector<Value::id_t>& key) const {
+        std::size_t h = 0;
+        for(Value::id_t id : key)
+            h = h * 31 + id;
+        return h;
+    }
+};
+
+}
+
+void Query::aggregate() {
+    typedef std::vector<Value::id_t> Key;
+    struct Group {
+        std::vector<unsigned long> counts; //!< COUNT results
+        std::vector<std::unordered_set<Value::id_t>> values; //!< DISTINCT values
+    };
+    typedef std::unordered_map<Key, Group, GroupKeyHash> GroupMap;
+    GroupMap groups;
+    std::vector<GroupMap::value_type*> order; // groups in order of appearance
+
+    // Stream the solutions of the pattern into the groups
+    Key key(groupBy_.size());
+    while(nextPatternSolution()) {
+        for(unsigned i = 0; i < groupBy_.size(); i++)
+            key[i] = groupBy_[i]->valueId();
+        GroupMap::iterator it = groups.find(key);
+        if(it == groups.end()) {
+            Group group;
+            group.counts.resize(aggregates_.size(), 0);
+            group.values.resize(aggregates_.size());
+            it = groups.emplace(key, std::move(group)).first;
+            order.push_back(&*it);
+        }
+        Group& group = it->second;
+        unsigned long n = pattern_->multiplicity();
+        for(unsigned i = 0; i < aggregates_.size(); i++) {
+            const CountAggregate& a = aggregates_[i];
+            if(a.argument() && !a.argument()->isBound())
+                continue;
+            if(a.isDistinct())
+                group.values[i].insert(a.argument()->valueId());
+            else
+                group.counts[i] += n;
+        }
+    }
+    if(groups.empty() && groupBy_.empty()) {
+        // a single group, even without solutions
+        Group group;
+        group.counts.resize(aggregates_.size(), 0);
+        group.values.resize(aggregates_.size());
+        order.push_back(&*groups.emplace(key, std::move(group)).first);
+    }
+
+    // Create the aggregated solutions
+    std::unordered_map<unsigned long, Value::id_t> countIds;
+    std::set<Key> rows;
+    for(GroupMap::value_type* group : order) {
+        for(unsigned i = 0; i < groupBy_.size(); i++)
+            groupBy_[i]->valueId(group->first[i]);
+        for(unsigned i = 0; i < aggregates_.size(); i++) {
+            unsigned long n = aggregates_[i].isDistinct() ?
+                        group->second.values[i].size() :
+                        group->second.counts[i];
+            Value::id_t& id = countIds[n];
+            if(id == 0) {
+                Value val;
+                val.fillInteger(n);
+                id = addComputed(val.ensureLexical());
+            }
+            aggregates_[i].result()->valueId(id);
+        }
+        if(distinct_) {
+            Key row(requested_);
+            for(unsigned i = 0; i < requested_; i++)
+                row[i] = vars_[i]->valueId();
+            if(!rows.insert(row).second)
+                continue;
+        }
+        solutions_->insert(new Solution(this));
+    }
+}
+
+Value::id_t Query::addComputed(const Value& val) {
+    computed_.push_back(val);
+    return store_->valuesCount() + computed_.size();
+}
+
 void Query::reset() {
     pattern_->discard();
     nbSols_ = 0;
+    pending_ = 0;
     if(distinctCstr_ != nullptr)
         distinctCstr_->reset();
+    if(bnbOrderCstr_ != nullptr)
+        bnbOrderCstr_->reset();
     if(solutions_ != nullptr) {
         for(Solution* sol : *solutions_)
             delete sol;
         solutions_->clear();
     }
+    computed_.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Profiling
+
+namespace {
+
+/**
+ * Write a JSON string literal.
+ */
+void writeJsonString(std::ostream& out, const std::string& str) {
+    static const char* HEX = "0123456789abcdef";
+    out << '"';
+    for(unsigned char ch : str) {
+        switch(ch) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n";  break;
+        case '\r': out << "\\r";  break;
+        case '\t': out << "\\t";  break;
+        default:
+            if(ch < 0x20)
+                out << "\\u00" << HEX[ch >> 4] << HEX[ch & 0xf];
+            else
+                out << ch;
+        }
+    }
+    out << '"';
+}
+
+}
+
+std::string Query::describe(const BasicTriple<VarVal>& triple) const {
+    std::ostringstream out;
+    for(int i = 0; i < triple.COMPONENTS; i++) {
+        VarVal v = triple[i];
+        if(i > 0)
+            out << ' ';
+        if(v.isVariable())
+            out << '?' << variable(v)->name();
+        else
+            out << lookupValue(v.valueId()).ensureDirectStrings(*store_);
+    }
+    return out.str();
+}
+
+void Query::profile(bool enable) {
+    solver_.profiling(enable);
+    if(enable) {
+        profileStart_.time = monotonicTime();
+        profileStart_.solutions = nbSols_;
+        profileStart_.backtracks = solver_.statBacktracks();
+        profileStart_.subtrees = solver_.statSubtrees();
+        profileStart_.post = solver_.statPost();
+        profileStart_.propagate = solver_.statPropagate();
+        profileStart_.ranges = store_->statTripleRanges();
+        profileStart_.triples = store_->statTriplesScanned();
+        profileStart_.pages = store_->statPagesRead();
+    }
+}
+
+void Query::writeProfile(std::ostream& out) const {
+    out << "{\"solutions\": " << nbSols_ - profileStart_.solutions
+        << ", \"time_ns\": " << monotonicTime() - profileStart_.time
+        << ", \"backtracks\": "
+        << solver_.statBacktracks() - profileStart_.backtracks
+        << ", \"subtrees\": " << solver_.statSubtrees() - profileStart_.subtrees
+        << ", \"post\": " << solver_.statPost() - profileStart_.post
+        << ", \"propagate\": "
+        << solver_.statPropagate() - profileStart_.propagate
+        << ", \"triple_ranges\": "
+        << store_->statTripleRanges() - profileStart_.ranges
+        << ", \"triples_scanned\": "
+        << store_->statTriplesScanned() - profileStart_.triples
+        << ", \"pages_read\": "
+        << store_->statPagesRead() - profileStart_.pages
+        << ",\n \"constraints\": [";
+    std::vector<cp::Constraint*> cstrs(solver_.profiled());
+    std::sort(cstrs.begin(), cstrs.end(),
+              [](cp::Constraint* a, cp::Constraint* b) {
+        return a->statTime() > b->statTime();
+    });
+    bool first = true;
+    for(cp::Constraint* c : cstrs) {
+        out << (first ? "\n  " : ",\n  ") << "{\"type\": ";
+        first = false;
+        writeJsonString(out, demangle(typeid(*c).name()));
+        auto it = triples_.find(c);
+        if(it != triples_.end()) {
+            out << ", \"triple\": ";
+            writeJsonString(out, describe(it->second));
+        }
+        out << ", \"calls\": " << c->statCalls()
+            << ", \"time_ns\": " << c->statTime() << "}";
+    }
+    out << "]}";
+}
+
+void Query::explain(std::ostream& out, bool analyze) {
+    if(analyze) {
+        reset();
+        pattern_->analyze(true);
+        profile(true);
+        try {
+            while(next());
+        } catch(...) {
+            profile(false);
+            pattern_->analyze(false);
+            throw;
+        }
+    }
+    if(distinct_)
+        out << "DISTINCT" << std::endl;
+    if(!orders_.empty())
+        out << "ORDER BY (" << orders_.size() << " clauses)" << std::endl;
+    if(isAggregate())
+        out << "GROUP BY (" << groupBy_.size() << " variables, "
+            << aggregates_.size() << " aggregates)" << std::endl;
+    if(limit_ >= 0)
+        out << "LIMIT " << limit_ << std::endl;
+    if(offset_ > 0)
+        out << "OFFSET " << offset_ << std::endl;
+    pattern_->explain(out, 0);
+    if(analyze) {
+        out << "Total: " << nbSols_ - profileStart_.solutions
+            << " solutions in "
+            << (monotonicTime() - profileStart_.time) / 1000000 << "ms, "
+            << store_->statTripleRanges() - profileStart_.ranges
+            << " triple ranges, "
+            << store_->statTriplesScanned() - profileStart_.triples
+            << " triples scanned, "
+            << store_->statPagesRead() - profileStart_.pages
+            << " pages read" << std::endl;
+        profile(false);
+        pattern_->analyze(false);
+    }
 }
 
 }
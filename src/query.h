@@ -22,8 +22,10 @@
 #include <iostream>
 #include <set>
 #include <vector>
+#include <unordered_map>
 
 #include "util.h"
+#include "budget.h"
 #include "librdfwrapper.h"
 #include "store.h"
 #include "solver/solver.h"
@@ -94,6 +96,27 @@ private:
     bool        descending_;
 };
 
+/**
+ * COUNT aggregate projected into a variable.
+ */
+class CountAggregate {
+public:
+    CountAggregate(Variable* result, Variable* argument, bool distinct) :
+        result_(result), argument_(argument), distinct_(distinct) {}
+
+    CountAggregate(const CountAggregate&) = default;
+    CountAggregate& operator=(const CountAggregate&) = default;
+
+    Variable* result()     const { return result_;   } //!< @return the result variable
+    Variable* argument()   const { return argument_; } //!< @return the counted variable or nullptr for COUNT(*)
+    bool      isDistinct() const { return distinct_; } //!< @return whether to only count distinct values
+
+private:
+    Variable* result_;
+    Variable* argument_;
+    bool      distinct_;
+};
+
 /**
  * SPARQL query
  */
@@ -163,6 +186,35 @@ public:
      */
     const std::vector<Order> orders() const { return orders_; }
 
+    /**
+     * @return the GROUP BY variables
+     */
+    const std::vector<Variable*>& groupBy() const { return groupBy_; }
+    /**
+     * @return the aggregates
+     */
+    const std::vector<CountAggregate>& aggregates() const { return aggregates_; }
+    /**
+     * @return whether the solutions of the pattern are grouped
+     */
+    bool isAggregate() const { return !groupBy_.empty() || !aggregates_.empty(); }
+
+    /**
+     * Get a value assigned to a variable. The value either comes from the
+     * store or has been computed by the query (e.g., the result of an
+     * aggregate).
+     *
+     * @param id the id of the value (within range 1..valuesCount() of the
+     *           store or a computed value)
+     * @return the value
+     */
+    Value lookupValue(Value::id_t id) const {
+        if(id <= store_->valuesCount())
+            return store_->lookupValue(id);
+        else
+            return computed_[id - store_->valuesCount() - 1];
+    }
+
     /**
      * @return the number of solutions found so far
      */
@@ -171,6 +223,8 @@ public:
     /**
      * Find the next solution
      * @return false if there are no more solutions, true otherwise
+     * @throws BudgetExceeded if the budget of the query is exceeded, reset()
+     *         must then be called before searching again
      */
     bool next();
 
@@ -179,6 +233,66 @@ public:
      */
     void reset();
 
+    /**
+     * @return the budget of the search, charged by next()
+     */
+    Budget& budget() { return budget_; }
+
+    /**
+     * Attribute a constraint to a triple pattern in the profile.
+     *
+     * @param c the constraint
+     * @param triple the triple pattern c stands for
+     */
+    void attribute(cp::Constraint* c, const BasicTriple<VarVal>& triple) {
+        triples_.insert({c, triple});
+    }
+
+    /**
+     * @param c a constraint
+     * @return the triple pattern c has been attributed to or nullptr if none
+     */
+    const BasicTriple<VarVal>* attributed(cp::Constraint* c) const {
+        auto it = triples_.find(c);
+        return it == triples_.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * @param triple a triple pattern of this query
+     * @return a human-readable representation of triple, with variable names
+     *         and values
+     */
+    std::string describe(const BasicTriple<VarVal>& triple) const;
+
+    /**
+     * Enable or disable profiling. Enabling profiling resets the counters of
+     * the profile.
+     *
+     * @param enable true to enable profiling, false to disable it
+     */
+    void profile(bool enable);
+
+    /**
+     * Write the profile gathered since profiling has been enabled, as a
+     * JSON object.
+     *
+     * @param out output stream
+     */
+    void writeProfile(std::ostream& out) const;
+
+    /**
+     * Write the execution plan of the query: the optimized pattern tree with
+     * the cardinality estimates of each node and the constraints posted in
+     * each basic graph pattern. With analyze, the query is first executed
+     * from the start, consuming all solutions, and the actual statistics of
+     * each node and constraint are written as well.
+     *
+     * @param out output stream
+     * @param analyze whether to execute the query
+     * @throws BudgetExceeded if analyzing exceeds the budget of the query
+     */
+    void explain(std::ostream& out, bool analyze);
+
 private:
     /**
      * Create a graph pattern from a rasqal_graph_pattern
@@ -212,6 +326,37 @@ private:
      */
     bool nextPatternSolution();
 
+    /**
+     * @return the number of solutions of the query the current solution of
+     *         the pattern stands for
+     */
+    unsigned long solutionMultiplicity();
+
+    /**
+     * Skip solutions without retrieving the values of the variables, unless
+     * the DISTINCT constraint needs them. If the last skipped solution of
+     * the pattern stands for more solutions than needed, it becomes the
+     * current one with the remaining count in pending_.
+     *
+     * @param n the number of solutions to skip
+     * @return false if there are no more solutions, true otherwise
+     */
+    bool skipSolutions(unsigned long n);
+
+    /**
+     * Group all solutions of the pattern and fill the solution set with the
+     * aggregated solutions.
+     */
+    void aggregate();
+
+    /**
+     * Create a computed value.
+     *
+     * @param val the value
+     * @return the id of the value (greater than valuesCount() of the store)
+     */
+    Value::id_t addComputed(const Value& val);
+
 private:
     Store*     store_;  //!< store associated to this query
     cp::Solver solver_; //!< CP solver
@@ -244,10 +389,32 @@ private:
      * ORDER BY clauses
      */
     std::vector<Order> orders_;
+    /**
+     * GROUP BY variables
+     */
+    std::vector<Variable*> groupBy_;
+    /**
+     * Aggregates
+     */
+    std::vector<CountAggregate> aggregates_;
+    /**
+     * Values computed by this query. The id of computed_[i] is
+     * store_->valuesCount() + i + 1.
+     */
+    std::vector<Value> computed_;
     /**
      * Number of solutions found so far.
      */
     unsigned nbSols_;
+    /**
+     * Does a solution of the pattern stand for multiplicity() solutions of
+     * the query?
+     */
+    bool replicate_;
+    /**
+     * Number of copies of the current solution still to return.
+     */
+    unsigned long pending_;
 
     typedef std::multiset<Solution*,DereferenceLess> SolutionSet;
     /**
@@ -264,6 +431,30 @@ private:
      * Static constraint for Branch-and-Bound or nullptr if not needed.
      */
     BnBOrderConstraint* bnbOrderCstr_;
+
+    /**
+     * Budget of the search
+     */
+    Budget budget_;
+
+    /**
+     * Triple patterns of the triple constraints.
+     */
+    std::unordered_map<cp::Constraint*, BasicTriple<VarVal>> triples_;
+    /**
+     * Snapshot of the counters when profiling has been enabled.
+     */
+    struct {
+        unsigned long long time;   //!< monotonic clock in nanoseconds
+        unsigned solutions;
+        unsigned long backtracks;
+        unsigned long subtrees;
+        unsigned long post;
+        unsigned long propagate;
+        unsigned long ranges;
+        unsigned long triples;
+        unsigned long pages;
+    } profileStart_;
 };
 
 std::ostream& operator<<(std::ostream& out, const Query& q);
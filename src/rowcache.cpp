@@ -0,0 +1,103 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "rowcache.h"
+
+#include "query.h"
+#include "constraints/row.h"
+
+namespace castor {
+
+RowCache::RowCache(const std::vector<Variable*>& keyVars,
+                   const std::vector<Variable*>& rowVars, std::size_t budget) :
+        keyVars_(keyVars), rowVars_(rowVars), key_(keyVars.size()),
+        size_(0), budget_(budget) {}
+
+const RowCache::Key& RowCache::currentKey() {
+    for(unsigned i = 0; i < keyVars_.size(); i++) {
+        keyVars_[i]->setFromCP();
+        key_[i] = keyVars_[i]->valueId();
+    }
+    return key_;
+}
+
+RowCache::Rows* RowCache::find(const Key& key) {
+    auto it = map_.find(key);
+    return it == map_.end() ? nullptr : &it->second;
+}
+
+RowCache::Rows* RowCache::insert(const Key& key) {
+    auto result = map_.emplace(key, Rows());
+    if(result.second)
+        size_ += key.size() + 1;
+    return &result.first->second;
+}
+
+bool RowCache::append(Rows* rows, unsigned long multiplicity) {
+    if(rowVars_.empty() && rows->size() > 0) {
+        // all rows are equal: only count them
+        rows->multiplicities[0] += multiplicity;
+        return true;
+    }
+    for(Variable* x : rowVars_) {
+        x->setFromCP();
+        rows->values.push_back(x->valueId());
+    }
+    rows->multiplicities.push_back(multiplicity);
+    size_ += rowVars_.size() + 1;
+    return !full();
+}
+
+void RowCache::clear() {
+    map_.clear();
+    size_ = 0;
+}
+
+RowReplay::RowReplay(Query* query, const std::vector<Variable*>& vars) :
+        sub_(query->solver()), width_(vars.size()), rows_(nullptr),
+        index_(0), row_(nullptr) {
+    std::vector<cp::RDFVar*> cpvars;
+    for(Variable* x : vars)
+        cpvars.push_back(x->cp());
+    sub_.add(query->solver()->make<RowConstraint>(query, cpvars, &row_));
+}
+
+bool RowReplay::next() {
+    if(sub_.isActive()) {
+        if(!sub_.isCurrent())
+            return true; // another subtree is posted further down
+        sub_.discard();
+        ++index_;
+    }
+    while(rows_ != nullptr && index_ < rows_->size()) {
+        row_ = rows_->values.data() + index_ * width_;
+        sub_.activate();
+        if(sub_.search())
+            return true;
+        ++index_;
+    }
+    rows_ = nullptr;
+    return false;
+}
+
+void RowReplay::discard() {
+    if(sub_.isActive())
+        sub_.discard();
+    rows_ = nullptr;
+}
+
+}
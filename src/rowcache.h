@@ -0,0 +1,184 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CASTOR_ROWCACHE_H
+#define CASTOR_ROWCACHE_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "model.h"
+#include "variable.h"
+#include "solver/subtree.h"
+
+namespace castor {
+
+class Query;
+
+/**
+ * Cache of solutions of a pattern. A solution is stored as a row holding
+ * the values of the row variables, grouped by the values of the key
+ * variables.
+ */
+class RowCache {
+public:
+    //! Values of the key variables
+    typedef std::vector<Value::id_t> Key;
+
+    /**
+     * Rows associated to a key
+     */
+    struct Rows {
+        std::vector<Value::id_t>    values; //!< concatenated rows
+        std::vector<unsigned long>  multiplicities; //!< multiplicity of each row
+
+        /**
+         * @return the number of rows
+         */
+        unsigned size() const { return multiplicities.size(); }
+    };
+
+    /**
+     * @param keyVars the key variables
+     * @param rowVars the row variables
+     * @param budget maximum number of stored values
+     */
+    RowCache(const std::vector<Variable*>& keyVars,
+             const std::vector<Variable*>& rowVars, std::size_t budget);
+
+    /**
+     * @return the row variables
+     */
+    const std::vector<Variable*>& rowVariables() const { return rowVars_; }
+
+    /**
+     * @return the key formed by the current values of the key variables in
+     *         the solver
+     */
+    const Key& currentKey();
+
+    /**
+     * @param key a key
+     * @return the rows associated to key or nullptr if key is unknown
+     */
+    Rows* find(const Key& key);
+
+    /**
+     * Get the rows associated to key, creating an empty entry if needed.
+     *
+     * @param key a key
+     * @return the rows associated to key
+     */
+    Rows* insert(const Key& key);
+
+    /**
+     * Append a row with the current values of the row variables in the
+     * solver. Without row variables, a single row is kept whose
+     * multiplicity is the sum of those of the appended rows.
+     *
+     * @param rows the rows to append to
+     * @param multiplicity the multiplicity of the row
+     * @return false if the budget is exceeded, true otherwise
+     */
+    bool append(Rows* rows, unsigned long multiplicity);
+
+    /**
+     * @return whether the budget has been exceeded
+     */
+    bool full() const { return size_ > budget_; }
+
+    /**
+     * Remove all entries.
+     */
+    void clear();
+
+private:
+    /**
+     * Hash function for keys
+     */
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            std::size_t h = 0;
+            for(Value::id_t id : key)
+                h = h * 31 + id;
+            return h;
+        }
+    };
+
+    std::vector<Variable*> keyVars_; //!< key variables
+    std::vector<Variable*> rowVars_; //!< row variables
+    std::unordered_map<Key, Rows, KeyHash> map_;
+    Key key_;            //!< buffer for currentKey()
+    std::size_t size_;   //!< number of stored values (including keys)
+    std::size_t budget_; //!< maximum number of stored values
+};
+
+/**
+ * Replay rows of a RowCache in the solver. Each row is bound in its own
+ * subtree, following the same protocol as Pattern::next().
+ */
+class RowReplay {
+public:
+    /**
+     * @param query the query
+     * @param vars the variables to bind (the row variables of the cache)
+     */
+    RowReplay(Query* query, const std::vector<Variable*>& vars);
+
+    /**
+     * Start replaying rows.
+     *
+     * @param rows the rows (nullptr for none)
+     */
+    void replay(const RowCache::Rows* rows) { rows_ = rows; index_ = 0; }
+
+    /**
+     * @return whether rows are being replayed
+     */
+    bool isReplaying() const { return rows_ != nullptr; }
+
+    /**
+     * Bind the next row.
+     *
+     * @return false if there are no more rows, true otherwise
+     */
+    bool next();
+
+    /**
+     * Stop replaying rows.
+     */
+    void discard();
+
+    /**
+     * @pre isReplaying()
+     * @return the multiplicity of the current row
+     */
+    unsigned long multiplicity() const {
+        return rows_->multiplicities[index_];
+    }
+
+private:
+    cp::Subtree sub_;
+    unsigned width_; //!< number of variables
+    const RowCache::Rows* rows_; //!< rows being replayed
+    unsigned index_; //!< index of the current row
+    const Value::id_t* row_; //!< current row
+};
+
+}
+
+#endif // CASTOR_ROWCACHE_H
@@ -0,0 +1,57 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "arena.h"
+
+#include <cstdlib>
+#include <cstdint>
+
+namespace castor {
+namespace cp {
+
+Arena::Arena(std::size_t blockSize) :
+        blockSize_(blockSize), ptr_(nullptr), end_(nullptr) {}
+
+Arena::~Arena() {
+    for(auto it = destructors_.rbegin(); it != destructors_.rend(); ++it)
+        it->second(it->first);
+    for(char* block : blocks_)
+        free(block);
+}
+
+void* Arena::allocate(std::size_t size, std::size_t align) {
+    std::uintptr_t p = reinterpret_cast<std::uintptr_t>(ptr_);
+    p = (p + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+    if(ptr_ == nullptr || p + size > reinterpret_cast<std::uintptr_t>(end_)) {
+        // malloc'ed blocks are suitably aligned for any type
+        std::size_t n = size > blockSize_ ? size : blockSize_;
+        char* block = reinterpret_cast<char*>(malloc(n));
+        if(block == nullptr)
+            throw std::bad_alloc();
+        blocks_.push_back(block);
+        if(size > blockSize_)
+            return block; // dedicated block, keep the current one
+        ptr_ = block;
+        end_ = block + n;
+        p = reinterpret_cast<std::uintptr_t>(ptr_);
+    }
+    ptr_ = reinterpret_cast<char*>(p + size);
+    return reinterpret_cast<void*>(p);
+}
+
+}
+}
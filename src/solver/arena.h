@@ -0,0 +1,92 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CASTOR_CP_ARENA_H
+#define CASTOR_CP_ARENA_H
+
+#include <vector>
+#include <utility>
+#include <new>
+#include <type_traits>
+#include <cstddef>
+
+namespace castor {
+namespace cp {
+
+/**
+ * Monotonic arena. Objects are constructed in large blocks by bumping a
+ * pointer and are all destroyed along with the arena, in reverse order of
+ * construction.
+ */
+class Arena {
+public:
+    /**
+     * Construct an empty arena.
+     *
+     * @param blockSize size of a block in bytes
+     */
+    Arena(std::size_t blockSize=16384);
+    ~Arena();
+
+    //! Non-copyable
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Allocate raw memory, freed with the arena.
+     *
+     * @param size number of bytes
+     * @param align alignment (power of two)
+     * @return pointer to the memory
+     */
+    void* allocate(std::size_t size, std::size_t align);
+
+    /**
+     * Construct an object in the arena.
+     *
+     * @param args arguments of the constructor
+     * @return the new object
+     */
+    template<class T, class... Args>
+    T* make(Args&&... args) {
+        T* obj = new(allocate(sizeof(T), alignof(T)))
+                T(std::forward<Args>(args)...);
+        if(!std::is_trivially_destructible<T>::value)
+            destructors_.emplace_back(obj, &destroy<T>);
+        return obj;
+    }
+
+private:
+    typedef void (*Destructor)(void* obj);
+
+    template<class T>
+    static void destroy(void* obj) { static_cast<T*>(obj)->~T(); }
+
+    std::size_t blockSize_;     //!< size of a block
+    std::vector<char*> blocks_; //!< allocated blocks
+    char* ptr_;                 //!< first free byte of the current block
+    char* end_;                 //!< end of the current block
+    /**
+     * Objects to destroy with the arena.
+     */
+    std::vector<std::pair<void*, Destructor>> destructors_;
+};
+
+}
+}
+
+#endif // CASTOR_CP_ARENA_H
@@ -0,0 +1,71 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bitset.h"
+
+namespace castor {
+namespace cp {
+
+ReversibleSparseBitSet::ReversibleSparseBitSet(Trail* trail, unsigned size) :
+        Trailable(trail) {
+    unsigned n = (size + WORD_BITS - 1) / WORD_BITS;
+    words_.assign(n, ~word_t(0));
+    if(size % WORD_BITS != 0)
+        words_[n - 1] = (word_t(1) << (size % WORD_BITS)) - 1;
+    mask_.assign(n, 0);
+    stamps_.assign(n, 0);
+    index_.resize(n);
+    for(unsigned i = 0; i < n; i++)
+        index_[i] = i;
+    limit_ = n;
+}
+
+void ReversibleSparseBitSet::clearMask() {
+    for(unsigned i = 0; i < limit_; i++)
+        mask_[index_[i]] = 0;
+}
+
+void ReversibleSparseBitSet::reverseMask() {
+    for(unsigned i = 0; i < limit_; i++)
+        mask_[index_[i]] = ~mask_[index_[i]];
+}
+
+bool ReversibleSparseBitSet::intersectWithMask() {
+    bool changed = false;
+    for(unsigned i = limit_; i-- > 0; ) {
+        unsigned offset = index_[i];
+        word_t w = words_[offset] & mask_[offset];
+        if(w == words_[offset])
+            continue;
+        changed = true;
+        modifyingPart(&words_[offset], &stamps_[offset]);
+        words_[offset] = w;
+        if(w == 0) {
+            /* Swapping indices needs no trailing: restoring limit_ brings
+             * back the same set of non-zero words.
+             */
+            modifying(&limit_);
+            --limit_;
+            index_[i] = index_[limit_];
+            index_[limit_] = offset;
+        }
+    }
+    return changed;
+}
+
+}
+}
@@ -0,0 +1,116 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CASTOR_CP_BITSET_H
+#define CASTOR_CP_BITSET_H
+
+#include <vector>
+#include <cstdint>
+
+#include "trail.h"
+
+namespace castor {
+namespace cp {
+
+/**
+ * Reversible sparse bitset. Only words that are not zero are kept in an
+ * index, so that operations on the set are proportional to the number of
+ * non-zero words. Words and the index limit are trailed lazily.
+ *
+ * Bits are only ever cleared, through a temporary mask: clear the mask, add
+ * words to it, optionally reverse it and intersect the set with it.
+ */
+class ReversibleSparseBitSet : public Trailable {
+public:
+    typedef uint64_t word_t;
+    static constexpr unsigned WORD_BITS = 64; //!< number of bits in a word
+
+    /**
+     * Construct a bitset containing bits 0..size-1.
+     */
+    ReversibleSparseBitSet(Trail* trail, unsigned size);
+    ReversibleSparseBitSet(Trail& trail, unsigned size) :
+        ReversibleSparseBitSet(&trail, size) {}
+
+    // Implementation
+    void save   (Trail& trail) const override { trail.push(limit_); }
+    void restore(Trail& trail)       override { limit_ = trail.pop<unsigned>(); }
+
+    /**
+     * @return whether all bits are cleared
+     */
+    bool empty() const { return limit_ == 0; }
+
+    /**
+     * @param i index of a word
+     * @return the i-th word of the set
+     */
+    word_t word(unsigned i) const { return words_[i]; }
+
+    /**
+     * @param bit a bit
+     * @return whether bit is set
+     */
+    bool contains(unsigned bit) const {
+        return (words_[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+    }
+
+    /**
+     * Clear the mask on the non-zero words.
+     */
+    void clearMask();
+
+    /**
+     * Add bits to the mask.
+     *
+     * @param i index of a word
+     * @param w bits to add to the i-th word of the mask
+     */
+    void addToMask(unsigned i, word_t w) { mask_[i] |= w; }
+
+    /**
+     * Reverse the mask on the non-zero words.
+     */
+    void reverseMask();
+
+    /**
+     * Intersect the set with the mask.
+     *
+     * @return whether some bits were cleared
+     */
+    bool intersectWithMask();
+
+private:
+    std::vector<word_t> words_;  //!< the bits
+    std::vector<word_t> mask_;   //!< temporary mask
+    /**
+     * Timestamps of the words for lazy trailing.
+     */
+    std::vector<Trail::timestamp_t> stamps_;
+    /**
+     * Indices of the words.
+     *
+     * @invariant words_[index_[i]] != 0 iff i < limit_
+     */
+    std::vector<unsigned> index_;
+    unsigned limit_; //!< number of non-zero words
+};
+
+}
+}
+
+#endif // CASTOR_CP_BITSET_H
@@ -164,6 +164,8 @@ public:
     // Implementation of virtual functions
     bool label() override;
     bool unlabel() override;
+    bool constrained() const override;
+    bool select(unsigned i) override { return bind(this->min_ + i); }
     unsigned dyndegree() const override;
 
     // Overrides to update size_
@@ -303,6 +305,19 @@ bool BoundsDecisionVariable<T>::unlabel() {
     return updateMin(this->min_ + 1);
 }
 
+template<class T>
+bool BoundsDecisionVariable<T>::constrained() const {
+    for(Constraint* c : this->evBind_) {
+        if(this->solver_->pending(c))
+            return true;
+    }
+    for(Constraint* c : this->evBounds_) {
+        if(this->solver_->pending(c))
+            return true;
+    }
+    return false;
+}
+
 template<class T>
 unsigned BoundsDecisionVariable<T>::dyndegree() const {
     unsigned deg = 0;
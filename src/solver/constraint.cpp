@@ -24,8 +24,11 @@ namespace cp {
 
 Constraint::Constraint(Solver* solver, Priority priority) :
     done_(solver->trail(), false),
+    idempotent_(true),
     priority_(priority),
-    nextPropag_(nullptr) {}
+    nextPropag_(nullptr),
+    statCalls_(0),
+    statTime_(0) {}
 
 }
 }
@@ -96,6 +96,16 @@ public:
      */
     bool done() const { return done_; }
 
+    /**
+     * @return the number of calls to post() and propagate() while profiling
+     */
+    unsigned long statCalls() const { return statCalls_; }
+    /**
+     * @return the time spent in post() and propagate() while profiling, in
+     *         nanoseconds
+     */
+    unsigned long long statTime() const { return statTime_; }
+
     /**
      * Initial propagation callback. It should perform the initial propagation
      * and return true if all went well or false if the propagation failed.
@@ -128,6 +138,13 @@ protected:
      */
     Reversible<bool> done_;
 
+    /**
+     * Does a single call to propagate() reach a fixpoint of this constraint?
+     * If true (the default), the events triggered by the constraint during
+     * its own propagation do not enqueue it again.
+     */
+    bool idempotent_;
+
 private:
     /**
      * Constraint priority. The priority is constant for a constraint.
@@ -142,6 +159,11 @@ private:
      * Timestamp of this constraint. This is only used for static constraints.
      */
     timestamp_t timestamp_;
+    /**
+     * Profiling counters, maintained by the solver.
+     */
+    unsigned long statCalls_;
+    unsigned long long statTime_; //!< in nanoseconds
 
     friend class Solver;
     friend class Subtree;
@@ -74,6 +74,10 @@ public:
     void restore(Trail& trail) override;
     bool label() override;
     bool unlabel() override;
+    bool constrained() const override;
+    bool select(unsigned i) override {
+        return contains(domain_[i]) && bind(domain_[i]);
+    }
     unsigned dyndegree() const override;
 
     /**
@@ -207,6 +211,12 @@ public:
     void registerBounds(Constraint* c) { evBounds_.push_back(c); ++degree_; }
 
 private:
+    /**
+     * Save the domain to the trail if necessary. Only the size and bounds
+     * need to be trailed: the order of the domain array is irrelevant.
+     */
+    void modifying() { Trailable::modifying(&size_, &min_, &max_); }
+
     Solver* solver_; //!< attached solver
 
     T minVal_; //!< lowest value in the initial domain
@@ -262,6 +272,43 @@ private:
     std::vector<Constraint*> evBounds_;
 };
 
+/**
+ * Values removed from the domain of a discrete variable since the last
+ * reset(). Removed values are kept right after the domain in the domain
+ * array, so the delta only needs to remember the previous size. It is reset
+ * automatically when the variable is restored.
+ */
+template<class T>
+class DomainDelta : public TrailListener {
+public:
+    DomainDelta(DiscreteVariable<T>* x) : x_(x), size_(x->size()) {
+        x->registerRestored(this);
+    }
+
+    void restored(Trailable*) override { reset(); }
+
+    /**
+     * @return the number of values removed since the last reset
+     */
+    unsigned size() const { return size_ - x_->size(); }
+    /**
+     * Values removed later are appended at the end, so indices stay valid
+     * while the domain keeps shrinking.
+     *
+     * @param i index, 0 <= i < size()
+     * @return the i-th removed value
+     */
+    T operator[](unsigned i) const { return (*x_)[size_ - 1 - i]; }
+    /**
+     * Forget the removed values.
+     */
+    void reset() { size_ = x_->size(); }
+
+private:
+    DiscreteVariable<T>* x_; //!< the variable
+    unsigned size_;          //!< size of the domain at the last reset
+};
+
 template<class T>
 std::ostream& operator<<(std::ostream& out, const DiscreteVariable<T>& x);
 
@@ -343,6 +390,23 @@ bool DiscreteVariable<T>::unlabel() {
     return remove(domain_[0]);
 }
 
+template<class T>
+bool DiscreteVariable<T>::constrained() const {
+    for(Constraint* c : evBind_) {
+        if(solver_->pending(c))
+            return true;
+    }
+    for(Constraint* c : evChange_) {
+        if(solver_->pending(c))
+            return true;
+    }
+    for(Constraint* c : evBounds_) {
+        if(solver_->pending(c))
+            return true;
+    }
+    return false;
+}
+
 template<class T>
 unsigned DiscreteVariable<T>::dyndegree() const {
     unsigned deg = 0;
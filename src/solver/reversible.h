@@ -50,7 +50,7 @@ public:
      * @return
      */
     Reversible<T>& operator=(const T& val) {
-        modifying();
+        modifying(&value_);
         value_ = val;
         return *this;
     }
@@ -150,7 +150,7 @@ ReversibleSet<T>::~ReversibleSet() {
 template<class T>
 void ReversibleSet<T>::remove(unsigned index) {
     assert(index >= 0 && index < size_);
-    modifying();
+    modifying(&size_);
     size_--;
     T v = values_[size_];
     values_[size_] = values_[index];
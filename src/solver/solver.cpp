@@ -17,6 +17,7 @@
  */
 #include "solver.h"
 
+#include "util.h"
 
 namespace castor {
 namespace cp {
@@ -25,7 +26,10 @@ Solver::Solver() {
     for(Constraint::Priority p = Constraint::PRIOR_FIRST;
         p <= Constraint::PRIOR_LAST; ++p)
         propagQueue_[p] = nullptr;
+    queued_ = 0;
     current_ = nullptr;
+    profiling_ = false;
+    budget_ = nullptr;
     tsCurrent_ = 0;
     tsLastConstraint_ = 0;
     statBacktracks_ = 0;
@@ -34,12 +38,7 @@ Solver::Solver() {
     statPropagate_ = 0;
 }
 
-Solver::~Solver() {
-    for(Constraint* c : constraints_)
-        delete c;
-    for(Trailable* x : collectVars_)
-        delete x;
-}
+Solver::~Solver() {}
 
 void Solver::add(Constraint* c) {
     c->solver_ = this;
@@ -55,16 +54,25 @@ void Solver::refresh(Constraint* c) {
 
 void Solver::enqueue(std::vector<Constraint*>& constraints) {
     for(Constraint* c : constraints) {
-        if(!c->done_ && c->nextPropag_ == unqueued() &&
+        if(c->nextPropag_ == unqueued() && !c->done_ &&
                 ((c->parent_ == nullptr && c->timestamp_ <= tsCurrent_) ||
                  (current_ != nullptr && c->parent_ == current_))) {
             Constraint::Priority p = c->priority();
             c->nextPropag_ = propagQueue_[p];
             propagQueue_[p] = c;
+            queued_ |= 1u << p;
         }
     }
 }
 
+bool Solver::pendingStatic() const {
+    for(Constraint* c : constraints_) {
+        if(!c->done_)
+            return true;
+    }
+    return false;
+}
+
 bool Solver::postStatic() {
     Constraint::timestamp_t ts = tsCurrent_;
     tsCurrent_ = tsLastConstraint_;
@@ -77,14 +85,8 @@ bool Solver::postStatic() {
     for(Constraint* c : constraints_) {
         if(c->timestamp_ > ts) {
             statPost_++;
-#ifdef CASTOR_CSTR_TIMING
-            rusage start;
-            getrusage(RUSAGE_SELF, &start);
-#endif
-            bool outcome = c->post();
-#ifdef CASTOR_CSTR_TIMING
-            addTiming(c, start);
-#endif
+            bool outcome = profiling_ ? timed(c, &Constraint::post)
+                                      : c->post();
             if(!outcome) {
                 /* Beware that some constraints are left in "propagating" state
                  * while they are not in queue. As we are inconsistent, we will
@@ -115,14 +117,8 @@ bool Solver::post(std::vector<Constraint *>* constraints) {
         // call initial propagation
         for(Constraint* c : constraints[p]) {
             statPost_++;
-#ifdef CASTOR_CSTR_TIMING
-            rusage start;
-            getrusage(RUSAGE_SELF, &start);
-#endif
-            bool outcome = c->post();
-#ifdef CASTOR_CSTR_TIMING
-            addTiming(c, start);
-#endif
+            bool outcome = profiling_ ? timed(c, &Constraint::post)
+                                      : c->post();
             if(!outcome) {
                 /* Beware that some constraints are left in "propagating" state
                  * while they are not in queue. As we are in initial propagation,
@@ -140,54 +136,66 @@ bool Solver::post(std::vector<Constraint *>* constraints) {
 }
 
 bool Solver::propagate() {
-    for(Constraint::Priority p = Constraint::PRIOR_FIRST;
-        p <= Constraint::PRIOR_LAST; ++p) {
-        if(propagQueue_[p] != nullptr) {
-            Constraint* c = propagQueue_[p];
-            propagQueue_[p] = c->nextPropag_;
-            statPropagate_++;
-#ifdef CASTOR_CSTR_TIMING
-            rusage start;
-            getrusage(RUSAGE_SELF, &start);
-#endif
-            bool outcome = c->propagate();
-#ifdef CASTOR_CSTR_TIMING
-            addTiming(c, start);
-#endif
+    while(queued_ != 0) {
+        // highest priority non-empty queue
+        Constraint::Priority p =
+                static_cast<Constraint::Priority>(__builtin_ctz(queued_));
+        Constraint* c = propagQueue_[p];
+        propagQueue_[p] = c->nextPropag_;
+        if(propagQueue_[p] == nullptr)
+            queued_ &= ~(1u << p);
+        // An idempotent constraint ignores the events it triggers itself
+        c->nextPropag_ = c->idempotent_ ? nullptr : unqueued();
+        statPropagate_++;
+        bool outcome;
+        try {
+            outcome = profiling_ ? timed(c, &Constraint::propagate)
+                                 : c->propagate();
+        } catch(...) {
+            // the search is aborted, c must be queued again once restored
             c->nextPropag_ = unqueued();
-            if(outcome)
-                return propagate();
-            else
-                return false;
+            throw;
         }
+        if(c->idempotent_)
+            c->nextPropag_ = unqueued();
+        if(!outcome)
+            return false;
     }
     return true;
 }
 
 void Solver::clearQueue() {
-    for(Constraint::Priority p = Constraint::PRIOR_FIRST;
-        p <= Constraint::PRIOR_LAST; ++p) {
+    while(queued_ != 0) {
+        Constraint::Priority p =
+                static_cast<Constraint::Priority>(__builtin_ctz(queued_));
         while(propagQueue_[p]) {
             Constraint* c = propagQueue_[p];
             propagQueue_[p] = c->nextPropag_;
             c->nextPropag_ = unqueued();
         }
+        queued_ &= ~(1u << p);
+    }
+}
+
+void Solver::profiling(bool enable) {
+    profiling_ = enable;
+    if(enable) {
+        for(Constraint* c : profiled_) {
+            c->statCalls_ = 0;
+            c->statTime_ = 0;
+        }
+        profiled_.clear();
     }
 }
 
-#ifdef CASTOR_CSTR_TIMING
-void Solver::addTiming(Constraint *c, const rusage& start) {
-    rusage stop;
-    getrusage(RUSAGE_SELF, &stop);
-    std::type_index key(typeid(*c));
-    ++statCstrCount_[key];
-    statCstrTime_[key] +=
-        ((long)(stop.ru_utime.tv_sec + stop.ru_stime.tv_sec -
-                start.ru_utime.tv_sec - start.ru_stime.tv_sec) * 1000L +
-         (long)(stop.ru_utime.tv_usec + stop.ru_stime.tv_usec -
-                start.ru_utime.tv_usec - start.ru_stime.tv_usec) / 1000L);
+bool Solver::timed(Constraint* c, bool (Constraint::*method)()) {
+    if(c->statCalls_++ == 0)
+        profiled_.push_back(c);
+    unsigned long long start = monotonicTime();
+    bool outcome = (c->*method)();
+    c->statTime_ += monotonicTime() - start;
+    return outcome;
 }
-#endif
 
 }
 }
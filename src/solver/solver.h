@@ -21,16 +21,11 @@
 #include <vector>
 
 #include "config.h"
+#include "budget.h"
 #include "trail.h"
+#include "arena.h"
 #include "constraint.h"
 
-#ifdef CASTOR_CSTR_TIMING
-#include <unordered_map>
-#include <typeinfo>
-#include <typeindex>
-#include <sys/time.h>
-#include <sys/resource.h>
-#endif
 
 namespace castor {
 namespace cp {
@@ -59,16 +54,21 @@ public:
     Trail& trail() { return trail_; }
 
     /**
-     * Take ownership of a variable.
-     * The variable will be deleted in the destructor of the solver.
+     * Construct an object owned by the solver, such as a variable or a
+     * constraint. The object is allocated in the arena of the solver and
+     * will be destroyed in its destructor.
      *
-     * @param x variable to collect
+     * @param args arguments of the constructor
+     * @return the new object
      */
-    void collect(Trailable* x) { collectVars_.push_back(x); }
+    template<class T, class... Args>
+    T* make(Args&&... args) {
+        return arena_.make<T>(std::forward<Args>(args)...);
+    }
 
     /**
      * Adds a static constraint.
-     * The solver takes ownership of the constraint.
+     * The constraint should have been created with make().
      *
      * @param c the constraint
      */
@@ -90,6 +90,20 @@ public:
      */
     MOCKABLE void enqueue(std::vector<Constraint*>& constraints_);
 
+    /**
+     * @param c a constraint
+     * @return whether c may still react to events, i.e., it is not entailed
+     *         and it is either static or posted in the current subtree
+     */
+    bool pending(const Constraint* c) const {
+        return !c->done_ && (c->parent_ == nullptr || c->parent_ == current_);
+    }
+
+    /**
+     * @return whether some static constraint is not entailed
+     */
+    bool pendingStatic() const;
+
     /**
      * @return the number of backtracks so far
      */
@@ -107,20 +121,35 @@ public:
      */
     unsigned long statPropagate()  const { return statPropagate_;  }
 
-#ifdef CASTOR_CSTR_TIMING
     /**
-     * @return number of times the constraint's propagate or post method has
-     *         been called, for each constraint type.
+     * Enable or disable profiling. While profiling, the calls to the post and
+     * propagate methods of each constraint are counted and timed. Enabling
+     * profiling resets these counters.
+     *
+     * @param enable
+     */
+    void profiling(bool enable);
+    /**
+     * @return whether profiling is enabled
      */
-    const std::unordered_map<std::type_index, unsigned long>&
-    statCstrCount() const { return statCstrCount_; }
+    bool profiling() const { return profiling_; }
     /**
-     * @return time in milliseconds spent in the constraint's propagate and post
-     *         methods, for each constraint type.
+     * @return the constraints called while profiling, by order of first call
      */
-    const std::unordered_map<std::type_index, unsigned long>&
-    statCstrTime() const { return statCstrTime_; }
-#endif
+    const std::vector<Constraint*>& profiled() const { return profiled_; }
+
+    /**
+     * Set the budget charged by the search, or nullptr for an unlimited
+     * search. The search throws BudgetExceeded once the budget is exceeded;
+     * the active subtrees should then be discarded.
+     *
+     * @param budget the budget (not owned by the solver)
+     */
+    void budget(Budget* budget) { budget_ = budget; }
+    /**
+     * @return the budget of the search or nullptr if unlimited
+     */
+    Budget* budget() const { return budget_; }
 
 private: // for subtree
     /**
@@ -140,9 +169,9 @@ private: // for subtree
     MOCKABLE bool post(std::vector<Constraint*>* constraints);
 
     /**
-     * Perform propagation of the constraints in the queue. After this call,
-     * either the queue is empty and we have reached the fixpoint, or a failure
-     * has been detected.
+     * Perform propagation of the constraints in the queue, highest priority
+     * first. After this call, either the queue is empty and we have reached
+     * the fixpoint, or a failure has been detected.
      *
      * @return false if there is a failure, true otherwise
      */
@@ -172,15 +201,21 @@ private:
      */
     Constraint* propagQueue_[Constraint::PRIOR_COUNT];
 
+    /**
+     * Bitmask of the non-empty propagation queues (bit p for priority p).
+     */
+    unsigned queued_;
+
     /**
      * Trail.
      */
     Trail trail_;
 
     /**
-     * Variables to delete in the destructor.
+     * Arena holding the objects owned by the solver. Declared after the
+     * trail, so that these objects are destroyed first.
      */
-    std::vector<Trailable*> collectVars_;
+    Arena arena_;
 
     /**
      * Current active subtree.
@@ -222,25 +257,28 @@ private:
      */
     unsigned long statPropagate_;
 
-#ifdef CASTOR_CSTR_TIMING
     /**
-     * Number of times the constraint's propagate or post method has been
-     * called, for each constraint type.
+     * Is profiling enabled?
      */
-    std::unordered_map<std::type_index, unsigned long> statCstrCount_;
+    bool profiling_;
     /**
-     * Time in milliseconds spent in the constraint's propagate and post
-     * methods, for each constraint type.
+     * Constraints called while profiling.
      */
-    std::unordered_map<std::type_index, unsigned long> statCstrTime_;
+    std::vector<Constraint*> profiled_;
     /**
-     * Add timing information.
+     * Call the post or propagate method of a constraint, accounting for the
+     * time spent.
      *
      * @param c the constraint
-     * @param start start time
+     * @param method the method to call
+     * @return the outcome of the method
+     */
+    bool timed(Constraint* c, bool (Constraint::*method)());
+
+    /**
+     * Budget of the search or nullptr if unlimited.
      */
-    void addTiming(Constraint* c, const rusage& start);
-#endif
+    Budget* budget_;
 
     friend class Subtree;
 };
@@ -45,16 +45,12 @@ struct Subtree::Checkpoint {
 Subtree::Subtree(Solver* solver) : solver_(solver) {
     trail_ = nullptr;
     active_ = false;
+    distinct_ = false;
+    enum_ = nullptr;
 }
 
 Subtree::~Subtree() {
-    // delete constraints
-    for(Constraint::Priority p = Constraint::PRIOR_FIRST;
-        p <= Constraint::PRIOR_LAST; ++p) {
-        for(Constraint* c : constraints_[p])
-            delete c;
-    }
-    // delete trail
+    // constraints are owned by the solver
     delete [] trail_;
 }
 
@@ -68,6 +64,20 @@ void Subtree::add(Constraint* c) {
     constraints_[c->priority()].push_back(c);
 }
 
+std::vector<Constraint*> Subtree::constraints() const {
+    std::vector<Constraint*> result;
+    for(Constraint::Priority p = Constraint::PRIOR_FIRST;
+        p <= Constraint::PRIOR_LAST; ++p)
+        result.insert(result.end(),
+                      constraints_[p].begin(), constraints_[p].end());
+    return result;
+}
+
+void Subtree::project(const std::vector<DecisionVariable*>& projected) {
+    distinct_ = true;
+    projected_ = projected;
+}
+
 void Subtree::activate() {
     if(isActive())
         throw CastorException() << "Cannot activate active subtree.";
@@ -83,19 +93,30 @@ void Subtree::activate() {
     trailIndex_ = -1;
     checkpoint(nullptr);
     solver_->current_ = nullptr;
-    if(solver_->tsCurrent_ < solver_->tsLastConstraint_)
-        inconsistent_ = !solver_->postStatic();
-    else
-        inconsistent_ = false;
+    try {
+        if(solver_->tsCurrent_ < solver_->tsLastConstraint_)
+            inconsistent_ = !solver_->postStatic();
+        else
+            inconsistent_ = false;
+    } catch(...) {
+        // aborted: leave this subtree current so that it can be discarded
+        solver_->current_ = this;
+        throw;
+    }
     solver_->current_ = this;
     inconsistent_ = inconsistent_ || !solver_->post(constraints_);
     started_ = false;
+    projectedDepth_ = -1;
+    enum_ = nullptr;
+    if(!inconsistent_)
+        updateProjection();
 }
 
 void Subtree::discard() {
     if(!isCurrent())
         throw CastorException()
             << "Only current active subtree can be discarded.";
+    enum_ = nullptr;
     if(trailIndex_ >= 0) {
         // backtrack root checkpoint
         trailIndex_ = 0;
@@ -117,6 +138,20 @@ bool Subtree::search() {
 
     DecisionVariable* x = nullptr;
     if(started_) { // the search has started, try to backtrack
+        if(enum_) {
+            // with every projected variable already bound, a single value
+            // was needed
+            if(projectedDepth_ < 0 && enumerate())
+                return true;
+            enum_ = nullptr;
+        }
+        if(solver_->budget_)
+            solver_->budget_->backtrack();
+        if(projectedDepth_ >= 0) {
+            // Every other solution below the checkpoint where all projected
+            // variables became bound has the same projection: skip them.
+            trailIndex_ = projectedDepth_;
+        }
         x = backtrack();
         if(!x) {
             discard();
@@ -131,9 +166,11 @@ bool Subtree::search() {
             // find unbound variable with smallest domain
             x = nullptr;
             double sx;
+            unsigned unbound = 0;
             for(DecisionVariable* y : vars_) {
                 if(y->bound())
                     continue;
+                ++unbound;
 #if CASTOR_SEARCH == CASTOR_SEARCH_dom
                 double sy = y->size();
 #elif CASTOR_SEARCH == CASTOR_SEARCH_deg
@@ -157,10 +194,33 @@ bool Subtree::search() {
             if(!x) { // we have a solution
                 return true;
             }
+            if(unbound == 1 && !x->constrained() && !solver_->pendingStatic()) {
+                // Every value of the last variable yields a solution:
+                // enumerate them without checkpoints nor propagation.
+                enum_ = x;
+                enumIndex_ = 0;
+                enumSize_ = x->size();
+                enumPoint_ = solver_->trail().checkpoint();
+                if(x->select(0) || enumerate())
+                    return true;
+                enum_ = nullptr;
+                if(solver_->budget_)
+                    solver_->budget_->backtrack();
+                x = backtrack();
+                if(!x) {
+                    discard();
+                    return false;
+                }
+                continue;
+            }
         }
         // Make a checkpoint and assign a value to the selected variable
+        if(solver_->budget_)
+            solver_->budget_->node();
         checkpoint(x);
         if(!x->label() || !solver_->propagate()) {
+            if(solver_->budget_)
+                solver_->budget_->backtrack();
             x = backtrack();
             if(!x) {
                 discard();
@@ -168,6 +228,7 @@ bool Subtree::search() {
             }
         } else {
             assert(x->bound());
+            updateProjection();
         }
     }
 }
@@ -187,6 +248,8 @@ DecisionVariable* Subtree::backtrack() {
         return nullptr;
     // restore domains
     Checkpoint* chkp = &trail_[trailIndex_--];
+    if(projectedDepth_ > trailIndex_)
+        projectedDepth_ = -1;
     solver_->trail().restore(chkp->trailpoint);
     solver_->tsCurrent_ = chkp->timestamp;
     // clear propagation queue
@@ -200,9 +263,30 @@ DecisionVariable* Subtree::backtrack() {
             return backtrack();
         if(!solver_->propagate())
             return backtrack();
+        updateProjection();
     }
     return chkp->x;
 }
 
+bool Subtree::enumerate() {
+    while(++enumIndex_ < enumSize_) {
+        solver_->trail().restore(enumPoint_);
+        if(enum_->select(enumIndex_))
+            return true;
+    }
+    solver_->trail().restore(enumPoint_);
+    return false;
+}
+
+void Subtree::updateProjection() {
+    if(!distinct_ || projectedDepth_ >= 0)
+        return;
+    for(DecisionVariable* x : projected_) {
+        if(!x->bound())
+            return;
+    }
+    projectedDepth_ = trailIndex_;
+}
+
 }
 }
@@ -61,7 +61,7 @@ public:
 
     /**
      * Add a constraint.
-     * The subtree takes ownership of the constraint.
+     * The constraint should have been created with Solver::make().
      *
      * @note Should not be called once the tree has been activated once.
      *
@@ -69,6 +69,26 @@ public:
      */
     void add(Constraint* c);
 
+    /**
+     * Only search for distinct assignments of the projected variables. Once
+     * all projected variables are bound and a solution has been found, the
+     * remaining choices below that point are skipped, as they could only
+     * yield solutions with the same projection.
+     *
+     * The projected variables should be decision variables of this subtree or
+     * be bound before its activation.
+     *
+     * @note Should not be called once the tree has been activated once.
+     *
+     * @param projected the projected variables (may be empty)
+     */
+    void project(const std::vector<DecisionVariable*>& projected);
+
+    /**
+     * @return the constraints of this subtree, by decreasing priority
+     */
+    std::vector<Constraint*> constraints() const;
+
     /**
      * @return whether this subtree is active
      */
@@ -116,6 +136,18 @@ private:
      */
     DecisionVariable* backtrack();
 
+    /**
+     * Record the current depth if all projected variables have become bound.
+     */
+    void updateProjection();
+
+    /**
+     * Bind enum_ to its next value, without propagation.
+     *
+     * @return false if all values have been enumerated, true otherwise
+     */
+    bool enumerate();
+
 private:
     /**
      * Parent solver.
@@ -147,6 +179,43 @@ private:
      */
     std::vector<DecisionVariable*> vars_;
 
+    /**
+     * Do we only search for distinct assignments of the projected variables?
+     */
+    bool distinct_;
+
+    /**
+     * Projected variables.
+     */
+    std::vector<DecisionVariable*> projected_;
+
+    /**
+     * Smallest trail index at which all projected variables are bound or -1
+     * if some projected variable is still unbound.
+     */
+    int projectedDepth_;
+
+    /**
+     * Last unbound variable, whose remaining values are enumerated directly
+     * as no constraint depends on them anymore, or nullptr.
+     */
+    DecisionVariable* enum_;
+
+    /**
+     * Index of the value of enum_ in its domain.
+     */
+    unsigned enumIndex_;
+
+    /**
+     * Size of the domain of enum_ before the enumeration.
+     */
+    unsigned enumSize_;
+
+    /**
+     * Trail checkpoint before the enumeration.
+     */
+    Trail::checkpoint_t enumPoint_;
+
     /**
      * Posted constraints.
      */
@@ -20,48 +20,75 @@
 namespace castor {
 namespace cp {
 
-Trail::Trail(std::size_t capacity) {
-    trail_ = reinterpret_cast<char*>(malloc(capacity));
-    end_ = trail_ + capacity;
-    ptr_ = trail_;
+Trail::Trail(std::size_t chunkSize) : chunkSize_(chunkSize) {
+    chunks_.push_back(reinterpret_cast<char*>(malloc(chunkSize_)));
+    chunk_ = 0;
+    base_ = chunks_[0];
+    end_ = base_ + chunkSize_;
+    ptr_ = base_;
     timestamp_ = 0;
 }
 
 Trail::~Trail() {
-    free(trail_);
+    for(char* chunk : chunks_)
+        free(chunk);
 }
 
-void Trail::enlargeSpace(std::size_t capacity) {
-    std::size_t size = end_ - trail_;
-    while(size < capacity)
-        size *= 2;
-    std::ptrdiff_t ptrpos = (ptr_ - trail_);
-    trail_ = reinterpret_cast<char*>(realloc(trail_, size));
-    end_ = trail_ + size;
-    ptr_ = trail_ + ptrpos;
+void Trail::nextChunk() {
+    if(chunk_ == used_.size())
+        used_.push_back(0);
+    used_[chunk_] = ptr_ - base_;
+    ++chunk_;
+    if(chunk_ == chunks_.size())
+        chunks_.push_back(reinterpret_cast<char*>(malloc(chunkSize_)));
+    base_ = chunks_[chunk_];
+    end_ = base_ + chunkSize_;
+    ptr_ = base_;
+}
+
+void Trail::previousChunk() {
+    --chunk_;
+    base_ = chunks_[chunk_];
+    end_ = base_ + chunkSize_;
+    ptr_ = base_ + used_[chunk_];
 }
 
 Trail::checkpoint_t Trail::checkpoint() {
     timestamp_++;
-    return ptr_ - trail_;
+    return position();
 }
 
 void Trail::restore(checkpoint_t chkp) {
-    while(ptr_ - trail_ > chkp) {
-        Trailable* x = pop<Trailable*>();
-        x->restore(*this);
+    while(position() > chkp) {
+        Restorer restorer = pop<Restorer>();
+        restorer(*this);
+    }
+    assert(position() == chkp);
+    timestamp_++;
+    for(Trailable* x : restored_) {
         for(TrailListener* listener : x->listeners_)
             listener->restored(x);
     }
-    assert(ptr_ - trail_ == chkp);
-    timestamp_++;
+    restored_.clear();
 }
 
 void Trail::save(Trailable *obj) {
     obj->save(*this);
     push(obj);
+    push<Restorer>(&restoreObject);
     obj->timestamp_ = timestamp_;
 }
 
+void Trail::restoreObject(Trail& trail) {
+    Trailable* x = trail.pop<Trailable*>();
+    x->restore(trail);
+    if(!x->listeners_.empty())
+        trail.restored_.push_back(x);
+}
+
+void Trail::restoreNotify(Trail& trail) {
+    trail.restored_.push_back(trail.pop<Trailable*>());
+}
+
 }
 }
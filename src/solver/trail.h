@@ -28,7 +28,14 @@ namespace cp {
 class Trailable;
 
 /**
- * A trail is a stack of information used to restore trailable objects.
+ * A trail is a stack of information used to restore trailable objects. It is
+ * stored in fixed-size chunks that are never moved nor freed before the
+ * trail is destroyed.
+ *
+ * Each entry of the trail ends with a restorer, i.e., a function popping the
+ * rest of the entry and restoring the state it describes. Entries are either
+ * whole trailable objects (saved with Trailable::save()) or typed value slots
+ * (address and old value, see Trailable::modifying(T*...)).
  */
 class Trail {
 public:
@@ -42,15 +49,25 @@ public:
      */
     typedef std::ptrdiff_t checkpoint_t;
 
+    /**
+     * Function popping and restoring an entry of the trail (the restorer
+     * itself has already been popped).
+     */
+    typedef void (*Restorer)(Trail& trail);
+
     /**
      * Construct a trail.
      *
-     * @param capacity initial capacity of the trail
+     * @param chunkSize size of a chunk in bytes
      */
-    Trail(std::size_t capacity=4096);
+    Trail(std::size_t chunkSize=65536);
 
     ~Trail();
 
+    //! Non-copyable
+    Trail(const Trail&) = delete;
+    Trail& operator=(const Trail&) = delete;
+
     /**
      * Make a checkpoint of the trail.
      *
@@ -59,7 +76,8 @@ public:
     checkpoint_t checkpoint();
 
     /**
-     * Restore a checkpoint.
+     * Restore a checkpoint. Listeners of the restored objects are notified
+     * once all entries have been restored.
      *
      * @param chkp a previous checkpoint
      */
@@ -73,7 +91,8 @@ public:
      */
     template<class T>
     void push(const T& val) {
-        ensureSpace(sizeof(T));
+        if(static_cast<std::size_t>(end_ - ptr_) < sizeof(T))
+            nextChunk();
         *((reinterpret_cast<T*&>(ptr_))++) = val;
     }
 
@@ -85,27 +104,30 @@ public:
      */
     template<class T>
     T pop() {
-        assert(ptr_ - sizeof(T) >= trail_);
-        return *(--(reinterpret_cast<T*&>(ptr_)));
+        assert(ptr_ - sizeof(T) >= base_);
+        T val = *(--(reinterpret_cast<T*&>(ptr_)));
+        if(ptr_ == base_ && chunk_ > 0)
+            previousChunk();
+        return val;
     }
 
 private:
     /**
-     * Enlarge the allocated space for the stack to be at least of the given
-     * capacity.
-     *
-     * @param capacity
+     * @return the current position in the trail
      */
-    void enlargeSpace(std::size_t capacity);
+    checkpoint_t position() const {
+        return chunk_ * chunkSize_ + (ptr_ - base_);
+    }
 
     /**
-     * Ensure there are at least size bytes free at the top of the stack.
-     * @param size
+     * Move to the next chunk, allocating it if needed.
      */
-    void ensureSpace(std::size_t size) {
-        if(static_cast<std::size_t>(end_ - ptr_) < size)
-            enlargeSpace(ptr_ - trail_ + size);
-    }
+    void nextChunk();
+
+    /**
+     * Move back to the end of the previous chunk.
+     */
+    void previousChunk();
 
     /**
      * Save the state of obj.
@@ -114,14 +136,68 @@ private:
      */
     void save(Trailable* obj);
 
+    /**
+     * Save the value at addr as a typed slot.
+     *
+     * @param addr
+     */
+    template<class T>
+    void saveValue(T* addr) {
+        push(*addr);
+        push(addr);
+        push<Restorer>(&restoreValue<T>);
+    }
+
+    /**
+     * Push an entry notifying the listeners of obj when restored.
+     *
+     * @param obj
+     */
+    void saveNotify(Trailable* obj) {
+        push(obj);
+        push<Restorer>(&restoreNotify);
+    }
+
+    //! Restorer of a trailable object
+    static void restoreObject(Trail& trail);
+    //! Restorer of a typed slot
+    template<class T>
+    static void restoreValue(Trail& trail) {
+        T* addr = trail.pop<T*>();
+        *addr = trail.pop<T>();
+    }
+    //! Restorer of a notification entry
+    static void restoreNotify(Trail& trail);
+
 private:
     /**
-     * The trail stack.
+     * Size of a chunk in bytes.
+     */
+    std::size_t chunkSize_;
+
+    /**
+     * The chunks of the trail stack.
+     */
+    std::vector<char*> chunks_;
+
+    /**
+     * Number of bytes used in each chunk below the current one (the end of
+     * a chunk may be unused).
+     */
+    std::vector<std::size_t> used_;
+
+    /**
+     * Index of the current chunk.
+     */
+    std::size_t chunk_;
+
+    /**
+     * Pointer to the beginning of the current chunk.
      */
-    char* trail_;
+    char* base_;
 
     /**
-     * Pointer to the byte just after the allocated trail stack.
+     * Pointer to the byte just after the current chunk.
      */
     char* end_;
 
@@ -136,6 +212,11 @@ private:
      */
     timestamp_t timestamp_;
 
+    /**
+     * Restored objects with listeners, to notify at the end of restore().
+     */
+    std::vector<Trailable*> restored_;
+
     friend class Trailable;
 };
 
@@ -216,6 +297,44 @@ protected:
             trail_->save(this);
     }
 
+    /**
+     * Save the given members to the trail as typed slots if necessary. This
+     * avoids the virtual calls to save() and restore(). Suitable for objects
+     * whose whole state lies in these members and which need no extra work
+     * once restored.
+     *
+     * @note This method shall be called by implementations before any
+     *       modification of the state.
+     *
+     * @param members pointers to the members making the state
+     */
+    template<class... T>
+    void modifying(T*... members) {
+        if(timestamp_ != trail_->timestamp_) {
+            int dummy[] = {(trail_->saveValue(members), 0)...};
+            (void) dummy;
+            if(!listeners_.empty())
+                trail_->saveNotify(this);
+            timestamp_ = trail_->timestamp_;
+        }
+    }
+
+    /**
+     * Save a single member to the trail as a typed slot if necessary, for
+     * objects made of many parts modified separately. The timestamp of each
+     * part is kept by the caller; that of the object is left untouched.
+     *
+     * @param member pointer to the part
+     * @param stamp timestamp of the part
+     */
+    template<class T>
+    void modifyingPart(T* member, Trail::timestamp_t* stamp) {
+        if(*stamp != trail_->timestamp_) {
+            trail_->saveValue(member);
+            *stamp = trail_->timestamp_;
+        }
+    }
+
 private:
     /**
      * The trail where this object writes its restore information.
@@ -69,6 +69,25 @@ public:
      */
     virtual bool unlabel() = 0;
 
+    /**
+     * @return whether some constraint registered to this variable may still
+     *         react to its events (see Solver::pending())
+     */
+    virtual bool constrained() const = 0;
+
+    /**
+     * Bind this variable to the i-th value of its domain. Restoring the
+     * domain after each call, select(0), ..., select(size()-1) bind the
+     * variable to each value of its domain exactly once. Appropriate events
+     * should be triggered.
+     *
+     * @pre !bound() and 0 <= i < size(), unchanged since the domain was
+     *      last restored
+     * @return false if the i-th value is not in the domain anymore (only
+     *         possible with inconsistent bounds), true otherwise
+     */
+    virtual bool select(unsigned i) = 0;
+
 protected:
     /**
      * Default constructor with bogus values for Trailable. As Trailable is
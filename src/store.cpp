@@ -48,7 +48,12 @@ String StringMapper::lookupString(String::id_t id) const {
 const unsigned char Store::MAGIC[] = {0xd0, 0xd4, 0xc5, 0xd8,
                                       'C', 'a', 's', 't', 'o', 'r'};
 
-Store::Store(const char* fileName, unsigned cacheCapacity) : db_(fileName) {
+Store::Store(const char* fileName, unsigned cacheCapacity,
+             unsigned resolveCapacity) :
+        db_(fileName),
+        stringCache_(resolveCapacity),
+        valueCache_(resolveCapacity),
+        statRanges_(0), statTriples_(0), statPages_(0), budget_(nullptr) {
     Cursor cur = db_.page(0);
 
     // check magic number and version format
@@ -88,6 +93,8 @@ Store::Store(const char* fileName, unsigned cacheCapacity) : db_(fileName) {
     values_.begin = cur.readInt();
     values_.index = new HashTree<4>(&db_, cur.readInt());
     values_.eqClasses = cur.readInt();
+    values_.numapprox = cur.readInt();
+    values_.numbers = cur.readInt();
     for(Value::Category cat = Value::CAT_BLANK; cat <= Value::CATEGORIES; ++cat)
         values_.categories[cat] = cur.readInt();
     values_.count = values_.categories[Value::CATEGORIES] - 1;
@@ -115,33 +122,55 @@ Value Store::lookupValue(Value::id_t id) const {
     return Value(cur);
 }
 
+void Store::interpretNumber(Value& val) const {
+    if(val.interpreted() || !(val.isInteger() || val.isFloating()))
+        return;
+    assert(val.id() >= values_.categories[Value::CAT_NUMERIC] &&
+           val.id() < values_.categories[Value::CAT_NUMERIC + 1]);
+    long n = db_.page(values_.numbers).peekSignedLong(
+                (val.id() - values_.categories[Value::CAT_NUMERIC]) * 8);
+    if(val.isInteger()) {
+        val.interpretInteger(n);
+    } else {
+        double d;
+        memcpy(&d, &n, sizeof(d));
+        val.interpretFloating(d);
+    }
+}
+
 void Store::resolve(String& str) const {
     if(str.resolved())
         return;
     assert(str.direct());
 
-    // look for pages containing the hash
-    Hash::hash_t hash = str.hash();
-    Cursor cur = strings_.index->lookup(hash);
-    if(!cur.valid()) {
-        str.id(0);
+    std::string key(str.str(), str.length());
+    String::id_t id;
+    if(stringCache_.lookup(key, id)) {
+        str.id(id);
         return;
     }
 
-    // scan all candidates in the collision list
-    Cursor end = db_.pageEnd(cur);
-    while(cur != end) {
-        if(cur.readInt() != hash)
-            break;
-        std::size_t offset = cur.readLong();
-        Cursor stringCur = db_.page(strings_.begin) + offset;
-        String s(stringCur);
-        if(s == str) {
-            str.id(s.id());
-            return;
+    // look for pages containing the hash
+    Hash::hash_t hash = str.hash();
+    Cursor cur = strings_.index->lookup(hash);
+    if(cur.valid()) {
+        // scan all candidates in the collision list
+        Cursor end = db_.pageEnd(cur);
+        while(cur != end) {
+            if(cur.readInt() != hash)
+                break;
+            std::size_t offset = cur.readLong();
+            Cursor stringCur = db_.page(strings_.begin) + offset;
+            String s(stringCur);
+            if(s == str) {
+                str.id(s.id());
+                break;
+            }
         }
     }
-    str.id(0);
+    if(!str.resolved())
+        str.id(0);
+    stringCache_.insert(key, str.id());
 }
 
 void Store::resolve(Value& val) const {
@@ -157,27 +186,43 @@ void Store::resolve(Value& val) const {
     val.ensureDirectStrings(*this);
     val.ensureResolvedStrings(*this);
 
-    // look for pages containing the hash
-    Hash::hash_t hash = val.hash();
-    Cursor cur = values_.index->lookup(hash);
-    if(!cur.valid()) {
-        val.id(0);
+    // serialize the fields compared by Value::operator==
+    std::string key;
+    key += static_cast<char>(val.category());
+    if(val.isNumeric())
+        key += static_cast<char>(val.numCategory());
+    if(val.isTyped())
+        key.append(val.datatypeLex().str(), val.datatypeLex().length());
+    else if(val.isPlainWithLang())
+        key.append(val.language().str(), val.language().length());
+    key += '\0';
+    key.append(val.lexical().str(), val.lexical().length());
+    Value::id_t id;
+    if(valueCache_.lookup(key, id)) {
+        val.id(id);
         return;
     }
 
-    // scan all candidates in the collision list
-    Cursor end = db_.pageEnd(cur);
-    while(cur != end) {
-        if(cur.readInt() != hash)
-            break;
-        Value::id_t id = cur.readInt();
-        Value v = lookupValue(id);
-        if(v == val) {
-            val.id(id);
-            return;
+    // look for pages containing the hash
+    Hash::hash_t hash = val.hash();
+    Cursor cur = values_.index->lookup(hash);
+    if(cur.valid()) {
+        // scan all candidates in the collision list
+        Cursor end = db_.pageEnd(cur);
+        while(cur != end) {
+            if(cur.readInt() != hash)
+                break;
+            Value::id_t candidate = cur.readInt();
+            Value v = lookupValue(candidate);
+            if(v == val) {
+                val.id(candidate);
+                break;
+            }
         }
     }
-    val.id(0);
+    if(val.id() == Value::UNKNOWN_ID)
+        val.id(0);
+    valueCache_.insert(key, val.id());
 }
 
 
@@ -339,32 +384,28 @@ unsigned Store::triplesCount(Triple pattern) {
     return count;
 }
 
+TripleOrder Store::chooseOrder(const Triple& from, const Triple& to) {
+    // non-singleton ranges are the last components
+    switch((from[0] != to[0]) |
+           (from[1] != to[1]) << 1 |
+           (from[2] != to[2]) << 2) {
+    case 4: // (s,p,*)
+    case 6: // (s,*,*)
+        return TripleOrder::SPO;
+    case 2: // (s,*,o)
+    case 3: // (*,*,o)
+        return TripleOrder::OSP;
+    default: // (s,p,o), (*,p,o), (*,p,*), (*,*,*)
+        return TripleOrder::POS;
+    }
+}
+
 Store::TripleRange::TripleRange(Store* store, Triple from, Triple to,
                                 TripleOrder order) :
         store_(store) {
-    if(order == TRIPLE_ORDER_AUTO) {
-        /* determine index such that non-singleton ranges are the last
-         * components
-         */
-        switch((from[0] != to[0]) |
-               (from[1] != to[1]) << 1 |
-               (from[2] != to[2]) << 2) {
-        case 0: // (s,p,o)
-        case 1: // (*,p,o)
-        case 5: // (*,p,*)
-        case 7: // (*,*,*)
-            order = TripleOrder::POS;
-            break;
-        case 4: // (s,p,*)
-        case 6: // (s,*,*)
-            order = TripleOrder::SPO;
-            break;
-        case 2: // (s,*,o)
-        case 3: // (*,*,o)
-            order = TripleOrder::OSP;
-            break;
-        }
-    }
+    ++store->statRanges_;
+    if(order == TRIPLE_ORDER_AUTO)
+        order = chooseOrder(from, to);
 
     Triple key;
 
@@ -398,6 +439,7 @@ Store::TripleRange::TripleRange(Store* store, Triple from, Triple to,
                  */
                 nextPage_--;
                 line_ = store->cache_.fetch(nextPage_);
+                ++store->statPages_;
                 nextPage_ = line_->first ? 0 : nextPage_ - 1;
                 it_       = line_->end() - 1;
                 end_      = line_->begin() - 1;
@@ -412,6 +454,7 @@ Store::TripleRange::TripleRange(Store* store, Triple from, Triple to,
 
     // lookup page in cache
     line_ = store->cache_.fetch(nextPage_);
+    ++store->statPages_;
     if(direction_ > 0) {
         nextPage_ = line_->last ? 0 : nextPage_ + 1;
         it_       = line_->findLower(key);
@@ -444,6 +487,7 @@ bool Store::TripleRange::next(Triple* t) {
         if(nextPage_ == 0)
             return false;
         line_ = store_->cache_.fetch(nextPage_);
+        ++store_->statPages_;
         if(direction_ > 0) {
             nextPage_ = line_->last ? 0 : nextPage_ + 1;
             it_       = line_->begin();
@@ -460,6 +504,30 @@ bool Store::TripleRange::next(Triple* t) {
     if(t != nullptr)
         *t = it_->toSPO(order_);
     it_ += direction_;
+    ++store_->statTriples_;
+    if(store_->budget_)
+        store_->budget_->triple();
+    return true;
+}
+
+Store::TripleRangeSet::TripleRangeSet(Store* store, Triple from, Triple to,
+                                      int component,
+                                      std::vector<Interval> intervals,
+                                      TripleOrder order) :
+        store_(store), from_(from), to_(to), component_(component),
+        intervals_(std::move(intervals)), interval_(0), order_(order) {}
+
+bool Store::TripleRangeSet::next(Triple* t) {
+    while(!range_ || !range_->next(t)) {
+        if(interval_ == intervals_.size()) {
+            range_.reset();
+            return false;
+        }
+        from_[component_] = intervals_[interval_].first;
+        to_[component_] = intervals_[interval_].second;
+        ++interval_;
+        range_.reset(new TripleRange(store_, from_, to_, order_));
+    }
     return true;
 }
 
@@ -22,11 +22,15 @@
 #include <string>
 #include <exception>
 #include <cassert>
+#include <memory>
+#include <utility>
 
 #include "util.h"
+#include "budget.h"
 #include "model.h"
 #include "store/btree.h"
 #include "store/triplecache.h"
+#include "store/resolvecache.h"
 #include "variable.h"
 
 namespace castor {
@@ -69,7 +73,7 @@ protected:
  */
 class Store : public StringMapper {
 public:
-    static constexpr unsigned      VERSION = 11; //!< format version
+    static constexpr unsigned      VERSION = 13; //!< format version
     static const     unsigned char MAGIC[10];    //!< magic number
 
     /**
@@ -77,9 +81,12 @@ public:
      *
      * @param fileName location of the store
      * @param cacheCapacity initial capacity of the triple cache
+     * @param resolveCapacity capacity of each of the resolved strings and
+     *                        values caches
      * @throws CastorException on error
      */
-    Store(const char* fileName, unsigned cacheCapacity=100);
+    Store(const char* fileName, unsigned cacheCapacity=100,
+          unsigned resolveCapacity=4096);
     ~Store();
 
     //! Non-copyable
@@ -128,6 +135,30 @@ public:
      */
     Value lookupValue(Value::id_t id) const;
 
+    /**
+     * Get the numeric approximation of a numeric value without decoding the
+     * value. The approximations are stored in a dense table.
+     *
+     * @param id identifier of the value (within range(Value::CAT_NUMERIC))
+     * @return lookupValue(id).numapprox().lower()
+     */
+    long numapprox(Value::id_t id) const {
+        assert(id >= values_.categories[Value::CAT_NUMERIC] &&
+               id < values_.categories[Value::CAT_NUMERIC + 1]);
+        return db_.page(values_.numapprox).peekSignedLong(
+                    (id - values_.categories[Value::CAT_NUMERIC]) * 8);
+    }
+
+    /**
+     * Interpret an xsd:integer or floating point value of the store from the
+     * dense table of native numbers, without looking up and parsing its
+     * lexical. Other values are left untouched: decimals have no exact
+     * native representation.
+     *
+     * @param[in,out] val a value of the store
+     */
+    void interpretNumber(Value& val) const;
+
     /**
      * Search for the id of a string (if id == UNKNOWN_ID) and replace it if
      * found.
@@ -211,8 +242,46 @@ public:
         return Triple::read(db_.page(triplesTable_) + index * Triple::SIZE);
     }
 
+    /**
+     * Set the budget charged for each triple returned by a triple range, or
+     * nullptr for none. Triple ranges throw BudgetExceeded once the budget is
+     * exceeded. As the store is shared, a query only installs its budget
+     * for the duration of a search (see BudgetScope).
+     *
+     * @param budget the budget (not owned by the store)
+     */
+    void budget(Budget* budget) { budget_ = budget; }
+    /**
+     * @return the budget charged by triple ranges or nullptr if none
+     */
+    Budget* budget() const { return budget_; }
+
+    /**
+     * Determine the index used to query a range of triples when no order is
+     * given: the components spanning more than one value come last.
+     *
+     * @param from lower bound
+     * @param to upper bound
+     * @return the chosen order
+     */
+    static TripleOrder chooseOrder(const Triple& from, const Triple& to);
+
     unsigned statTripleCacheHits()   const { return cache_.statHits();   }
     unsigned statTripleCacheMisses() const { return cache_.statMisses(); }
+    unsigned statTripleCacheEvictions() const { return cache_.statEvictions(); }
+    unsigned statTripleCacheSize()      const { return cache_.size();          }
+    unsigned statTripleCacheCapacity()  const { return cache_.capacity();      }
+    unsigned statResolveCacheHits()   const { return stringCache_.statHits() +
+                                                     valueCache_.statHits(); }
+    unsigned statResolveCacheMisses() const { return stringCache_.statMisses() +
+                                                     valueCache_.statMisses(); }
+    unsigned long statTripleRanges()   const { return statRanges_;  }
+    unsigned long statTriplesScanned() const { return statTriples_; }
+    unsigned long statPagesRead()      const { return statPages_;   }
+    std::size_t   statFileSize()       const { return db_.file().size(); }
+    std::size_t   statResidentSize()   const {
+        return db_.file().residentSize();
+    }
 
     /**
      * Query a range of triples.
@@ -258,6 +327,54 @@ public:
         const TripleCache::Line* line_; //!< current cache line
     };
 
+    /**
+     * Query a range of triples in which one component is further restricted
+     * to a sorted list of disjoint intervals. Each interval is scanned with
+     * its own TripleRange, so that the pages between intervals are skipped.
+     * Intervals made of a single value amount to point lookups.
+     */
+    class TripleRangeSet {
+    public:
+        typedef std::pair<Value::id_t, Value::id_t> Interval;
+
+        /**
+         * Construct a new query.
+         * @param store the store
+         * @param from lower bound
+         * @param to upper bound
+         * @param component the restricted component
+         * @param intervals sorted disjoint intervals of values of component
+         * @param order which index to use
+         */
+        TripleRangeSet(Store* store, Triple from, Triple to, int component,
+                       std::vector<Interval> intervals,
+                       TripleOrder order=TRIPLE_ORDER_AUTO);
+
+        //! Non-copyable
+        TripleRangeSet(const TripleRangeSet&) = delete;
+        TripleRangeSet& operator=(const TripleRangeSet&) = delete;
+
+        /**
+         * Fetch the next result statement
+         *
+         * @param[out] t structure in which to write the result or
+         *               nullptr to ignore
+         * @return true if the next result has been found, false if there are
+         *         no more results
+         */
+        bool next(Triple* t);
+
+    private:
+        Store*                       store_;
+        Triple                       from_;      //!< the lower bound
+        Triple                       to_;        //!< the upper bound
+        int                          component_; //!< restricted component
+        std::vector<Interval>        intervals_; //!< values of component_
+        unsigned                     interval_;  //!< next interval to scan
+        TripleOrder                  order_;     //!< index to use
+        std::unique_ptr<TripleRange> range_;     //!< current interval
+    };
+
 private:
     PageReader db_;
 
@@ -304,6 +421,8 @@ private:
         unsigned       begin;     //!< first page of table
         HashTree<4>*   index;     //!< index (hash->page mapping)
         unsigned       eqClasses; //!< first page of equivalence classes boundaries
+        unsigned       numapprox; //!< first page of numeric approximations
+        unsigned       numbers;   //!< first page of native numbers
 
         //! first id of each category
         Value::id_t categories[Value::CATEGORIES + 1];
@@ -312,8 +431,17 @@ private:
 
     TripleCache cache_; //!< triples cache
 
+    mutable ResolveCache<String::id_t> stringCache_; //!< resolved strings cache
+    mutable ResolveCache<Value::id_t>  valueCache_;  //!< resolved values cache
+
     std::vector<cp::RDFVar*> varcache_; //!< variables cache
 
+    unsigned long statRanges_;  //!< number of triple ranges queried
+    unsigned long statTriples_; //!< number of triples returned by ranges
+    unsigned long statPages_;   //!< number of pages read by ranges
+
+    Budget* budget_; //!< budget charged by triple ranges (nullptr if none)
+
     friend class TripleRange;
 };
 
@@ -0,0 +1,105 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CASTOR_STORE_RESOLVECACHE_H
+#define CASTOR_STORE_RESOLVECACHE_H
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace castor {
+
+/**
+ * Thread-safe LRU cache of resolved identifiers, keyed on a serialized form
+ * of the resolved object. Unknown objects (id 0) are cached as well.
+ *
+ * @param ID type of the identifiers
+ */
+template<class ID>
+class ResolveCache {
+public:
+    /**
+     * @param capacity maximum number of entries
+     */
+    ResolveCache(unsigned capacity) :
+        capacity_(capacity), statHits_(0), statMisses_(0) {}
+
+    //! Non-copyable
+    ResolveCache(const ResolveCache&) = delete;
+    ResolveCache& operator=(const ResolveCache&) = delete;
+
+    /**
+     * Look up a key.
+     *
+     * @param key the key
+     * @param[out] id the cached identifier if found
+     * @return whether the key was found
+     */
+    bool lookup(const std::string& key, ID& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if(it == index_.end()) {
+            ++statMisses_;
+            return false;
+        }
+        ++statHits_;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        id = it->second->second;
+        return true;
+    }
+
+    /**
+     * Insert a resolved identifier, evicting the least recently used entry
+     * if needed.
+     *
+     * @param key the key
+     * @param id the identifier
+     */
+    void insert(const std::string& key, ID id) {
+        if(capacity_ == 0)
+            return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(index_.find(key) != index_.end())
+            return;
+        if(entries_.size() >= capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        entries_.emplace_front(key, id);
+        index_[key] = entries_.begin();
+    }
+
+    unsigned statHits()   const { return statHits_; }
+    unsigned statMisses() const { return statMisses_; }
+
+private:
+    typedef std::list<std::pair<std::string, ID>> List;
+
+    unsigned capacity_;  //!< maximum number of entries
+    List entries_;       //!< entries, most recently used first
+    std::unordered_map<std::string, typename List::iterator> index_;
+    std::mutex mutex_;
+
+    unsigned statHits_;   //!< number of cache hits
+    unsigned statMisses_; //!< number of cache misses
+};
+
+}
+
+#endif // CASTOR_STORE_RESOLVECACHE_H
@@ -387,6 +387,7 @@ unsigned FullyAggregatedTriple::readPage(Cursor cur, Cursor end, Triple *triples
 TripleCache::TripleCache() {
     statHits_ = 0;
     statMisses_ = 0;
+    statEvictions_ = 0;
 }
 
 TripleCache::~TripleCache() {
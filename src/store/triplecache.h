@@ -287,8 +287,14 @@ public:
      */
     void peek(unsigned page, bool& first, bool& last, Triple& firstKey);
 
-    unsigned statHits()   const { return statHits_; }
-    unsigned statMisses() const { return statMisses_; }
+    unsigned statHits()      const { return statHits_; }
+    unsigned statMisses()    const { return statMisses_; }
+    unsigned statEvictions() const { return statEvictions_; }
+
+    //! @return the number of cache lines in use
+    unsigned size()     const { return lines_.size(); }
+    //! @return the number of cache lines before evicting
+    unsigned capacity() const { return lines_.capacity(); }
 
 private:
     PageReader* db_;
@@ -302,6 +308,7 @@ private:
 
     unsigned statHits_;        //!< number of cache hits
     unsigned statMisses_;      //!< number of cache misses
+    unsigned statEvictions_;   //!< number of evicted cache lines
 };
 
 
@@ -345,6 +352,7 @@ const TripleCache::Line* TripleCache::fetch(unsigned page) {
         else
             tail_->next_ = nullptr;
         map_[line->page] = nullptr;
+        ++statEvictions_;
     } else {
         // intialize new line (possibly increasing capacity)
         line = new Line;
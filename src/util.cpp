@@ -17,6 +17,10 @@
  */
 #include "util.h"
 
+#include <ctime>
+#include <cstdlib>
+#include <vector>
+#include <cxxabi.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -311,6 +315,22 @@ Hash::hash_t Hash::hash(const void *key, size_t length, hash_t initval) {
   return c;
 }
 
+unsigned long long monotonicTime() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+std::string demangle(const char* name) {
+    int status;
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if(demangled == nullptr)
+        return name;
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+}
+
 MMapFile::MMapFile(const char* fileName) {
     fd_ = open(fileName, O_RDONLY);
     if(fd_ == -1)
@@ -325,6 +345,19 @@ MMapFile::MMapFile(const char* fileName) {
     end_ = begin_ + size;
 }
 
+std::size_t MMapFile::residentSize() const {
+    std::size_t pageSize = sysconf(_SC_PAGESIZE);
+    std::size_t pages = (size() + pageSize - 1) / pageSize;
+    std::vector<unsigned char> vec(pages);
+    if(mincore(const_cast<unsigned char*>(begin_.get()), size(),
+               vec.data()) != 0)
+        return 0;
+    std::size_t resident = 0;
+    for(unsigned char v : vec)
+        resident += v & 1;
+    return std::min(resident * pageSize, size());
+}
+
 MMapFile::~MMapFile() {
     munmap(const_cast<unsigned char*>(begin_.get()), end_ - begin_);
     close(fd_);
@@ -66,8 +66,10 @@ public:
         return *this;
     }
 
-    // FIXME: garbage collection?
-    const char* what() const throw() { return msg_.str().c_str(); }
+    const char* what() const throw() {
+        what_ = msg_.str();
+        return what_.c_str();
+    }
 
     template<typename T>
     CastorException& operator<<(const T& t) {
@@ -77,6 +79,7 @@ public:
 
 private:
     std::ostringstream msg_;
+    mutable std::string what_; //!< storage of the string returned by what()
 };
 
 /**
@@ -114,6 +117,17 @@ static inline int fls(int i) {
     return result;
 }
 
+/**
+ * @return the value of the monotonic clock in nanoseconds
+ */
+unsigned long long monotonicTime();
+
+/**
+ * @param name a mangled type name, e.g., from std::type_info::name()
+ * @return the demangled name or name itself if it cannot be demangled
+ */
+std::string demangle(const char* name);
+
 /**
  * Pointer in a mapped file
  */
@@ -558,6 +572,11 @@ public:
     //! @return size of the file
     std::size_t size() const { return end_ - begin_; }
 
+    /**
+     * @return the number of bytes of the file currently resident in memory
+     */
+    std::size_t residentSize() const;
+
 private:
     int    fd_;    //!< file descriptor
     Cursor begin_; //!< start of the file
@@ -593,6 +612,11 @@ public:
         return it + (PAGE_SIZE - (it - in_.begin()) % PAGE_SIZE);
     }
 
+    /**
+     * @return the underlying file
+     */
+    const MMapFile& file() const { return in_; }
+
 private:
     MMapFile in_;
 };
@@ -0,0 +1,47 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "querycache.h"
+#include "gtest/gtest.h"
+
+using castor::QueryCache;
+
+/**
+ * Whitespace and comments are collapsed outside literals and IRIs
+ */
+TEST(CastordQueryCacheTest, Normalize) {
+    EXPECT_EQ("SELECT * WHERE {\n?s <http://ex/p> \"a  b\" }",
+              QueryCache::normalize("SELECT  *\tWHERE {\n ?s <http://ex/p>"
+                                    " \"a  b\" } # comment"));
+    EXPECT_EQ("SELECT * WHERE { ?s ?p ?o FILTER(?o < 3) }",
+              QueryCache::normalize("SELECT * WHERE { ?s ?p ?o "
+                                    "FILTER(?o  <  3) }"));
+}
+
+/**
+ * A single quote inside an IRI should not desynchronize literal tracking
+ */
+TEST(CastordQueryCacheTest, QuoteInIRI) {
+    EXPECT_NE(QueryCache::normalize("SELECT * WHERE { <http://ex/it's> ?p "
+                                    "\"x'  y\" }"),
+              QueryCache::normalize("SELECT * WHERE { <http://ex/it's> ?p "
+                                    "\"x' y\" }"));
+    EXPECT_NE(QueryCache::normalize("SELECT * WHERE { ?s ?p ?o "
+                                    "FILTER(?o<'a>b' && ?s = \"c  d\") }"),
+              QueryCache::normalize("SELECT * WHERE { ?s ?p ?o "
+                                    "FILTER(?o<'a>b' && ?s = \"c d\") }"));
+}
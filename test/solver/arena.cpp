@@ -0,0 +1,59 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solver/arena.h"
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <cstdint>
+
+using namespace castor::cp;
+
+/**
+ * Object recording its destruction.
+ */
+struct Tracked {
+    Tracked(std::vector<int>* log, int id) : log(log), id(id) {}
+    ~Tracked() { log->push_back(id); }
+    std::vector<int>* log;
+    int id;
+};
+
+/**
+ * Objects should be aligned and destroyed with the arena in reverse order
+ */
+TEST(SolverArenaTest, Make) {
+    std::vector<int> log;
+    {
+        Arena arena(64);
+        for(int i = 0; i < 10; i++) {
+            Tracked* obj = arena.make<Tracked>(&log, i);
+            EXPECT_EQ(i, obj->id);
+            EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(obj) %
+                          alignof(Tracked));
+            char* c = arena.make<char>('a'); // misalign the next object
+            EXPECT_EQ('a', *c);
+        }
+        // larger than a block
+        char* big = static_cast<char*>(arena.allocate(1000, 1));
+        big[999] = 'b';
+        arena.make<Tracked>(&log, 10);
+        EXPECT_TRUE(log.empty());
+    }
+    std::vector<int> expected = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+    EXPECT_EQ(expected, log);
+}
@@ -0,0 +1,83 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solver/bitset.h"
+#include "gtest/gtest.h"
+
+using namespace castor::cp;
+
+/**
+ * A new bitset should contain exactly bits 0..size-1
+ */
+TEST(SolverBitSetTest, Init) {
+    Trail trail;
+    ReversibleSparseBitSet set(trail, 70);
+    EXPECT_FALSE(set.empty());
+    for(unsigned b = 0; b < 70; b++)
+        EXPECT_TRUE(set.contains(b)) << "with bit " << b;
+    EXPECT_EQ(0u, set.word(1) >> 6);
+
+    ReversibleSparseBitSet none(trail, 0);
+    EXPECT_TRUE(none.empty());
+}
+
+/**
+ * Intersections should clear bits and be restored with the trail
+ */
+TEST(SolverBitSetTest, Intersect) {
+    Trail trail;
+    ReversibleSparseBitSet set(trail, 130);
+
+    Trail::checkpoint_t chkp = trail.checkpoint();
+    // remove bits 3 and 64..127
+    set.clearMask();
+    set.addToMask(0, 1 << 3);
+    set.addToMask(1, ~ReversibleSparseBitSet::word_t(0));
+    set.reverseMask();
+    EXPECT_TRUE(set.intersectWithMask());
+    EXPECT_FALSE(set.contains(3));
+    EXPECT_TRUE(set.contains(4));
+    EXPECT_FALSE(set.contains(64));
+    EXPECT_FALSE(set.contains(127));
+    EXPECT_TRUE(set.contains(128));
+
+    Trail::checkpoint_t chkp2 = trail.checkpoint();
+    // keep only bit 5
+    set.clearMask();
+    set.addToMask(0, 1 << 5);
+    EXPECT_TRUE(set.intersectWithMask());
+    EXPECT_TRUE(set.contains(5));
+    EXPECT_FALSE(set.contains(4));
+    EXPECT_FALSE(set.contains(128));
+    // keep nothing
+    set.clearMask();
+    EXPECT_TRUE(set.intersectWithMask());
+    EXPECT_TRUE(set.empty());
+    set.clearMask();
+    EXPECT_FALSE(set.intersectWithMask());
+
+    trail.restore(chkp2);
+    EXPECT_FALSE(set.empty());
+    EXPECT_FALSE(set.contains(3));
+    EXPECT_TRUE(set.contains(4));
+    EXPECT_FALSE(set.contains(100));
+    EXPECT_TRUE(set.contains(129));
+
+    trail.restore(chkp);
+    for(unsigned b = 0; b < 130; b++)
+        EXPECT_TRUE(set.contains(b)) << "with bit " << b;
+}
@@ -783,3 +783,32 @@ TEST_F(SolverDiscreteVarTest, UpdateMaxBind) {
     EXPECT_TRUE(y.updateMax(5));
     EXPECT_DOMAIN_SYNC(y, 5);
 }
+
+/**
+ * DomainDelta should list removed values, oldest first, until reset or restore
+ */
+TEST_F(SolverDiscreteVarTest, Delta) {
+    DomainDelta<unsigned> delta(&x);
+    EXPECT_EQ(0u, delta.size());
+
+    Trail::checkpoint_t chkp = solver.trail().checkpoint();
+    EXPECT_TRUE(x.remove(3));
+    EXPECT_TRUE(x.remove(7));
+    ASSERT_EQ(2u, delta.size());
+    EXPECT_EQ(3u, delta[0]);
+    EXPECT_EQ(7u, delta[1]);
+    EXPECT_TRUE(x.remove(5));
+    ASSERT_EQ(3u, delta.size());
+    EXPECT_EQ(3u, delta[0]);
+    EXPECT_EQ(7u, delta[1]);
+    EXPECT_EQ(5u, delta[2]);
+
+    delta.reset();
+    EXPECT_EQ(0u, delta.size());
+    EXPECT_TRUE(x.remove(0));
+    ASSERT_EQ(1u, delta.size());
+    EXPECT_EQ(0u, delta[0]);
+
+    solver.trail().restore(chkp);
+    EXPECT_EQ(0u, delta.size());
+}
@@ -0,0 +1,189 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <set>
+#include <utility>
+
+#include "solver/subtree.h"
+#include "solver/discretevar.h"
+#include "gtest/gtest.h"
+
+using namespace castor::cp;
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixture
+
+typedef DiscreteVariable<unsigned> Var;
+
+/**
+ * Binds x to the value of y once y is bound.
+ */
+class CopyConstraint : public Constraint {
+public:
+    CopyConstraint(Solver* solver, Var* x, Var* y) :
+            Constraint(solver, PRIOR_HIGH), x_(x), y_(y) {
+        y->registerBind(this);
+    }
+    bool propagate() override {
+        if(y_->bound()) {
+            done_ = true;
+            return x_->bind(y_->value());
+        }
+        return true;
+    }
+private:
+    Var* x_;
+    Var* y_;
+};
+
+class SolverSubtreeTest : public ::testing::Test {
+protected:
+    Solver solver;
+    Var x, y, z;
+    Subtree sub;
+
+    SolverSubtreeTest() : x(&solver, 1, 3), y(&solver, 1, 2), z(&solver, 1, 4),
+        sub(&solver) {
+        sub.add(&x);
+        sub.add(&y);
+        sub.add(&z);
+        sub.add(solver.make<CopyConstraint>(&solver, &x, &y));
+    }
+
+    /**
+     * Enumerate all solutions of the subtree.
+     * @return the number of solutions
+     */
+    unsigned countSolutions() {
+        unsigned n = 0;
+        sub.activate();
+        while(sub.search())
+            n++;
+        return n;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Tests
+
+TEST_F(SolverSubtreeTest, All) {
+    EXPECT_EQ(8u, countSolutions());
+    EXPECT_FALSE(sub.isActive());
+    EXPECT_EQ(3u, x.size());
+    EXPECT_EQ(4u, z.size());
+}
+
+TEST_F(SolverSubtreeTest, Projected) {
+    // x is bound by propagation after y has been labeled
+    sub.project({&x});
+    EXPECT_EQ(2u, countSolutions());
+    EXPECT_EQ(3u, x.size());
+}
+
+TEST_F(SolverSubtreeTest, ProjectedNone) {
+    sub.project({});
+    EXPECT_EQ(1u, countSolutions());
+}
+
+TEST_F(SolverSubtreeTest, Reactivate) {
+    sub.project({&x, &z});
+    EXPECT_EQ(8u, countSolutions());
+    EXPECT_EQ(8u, countSolutions());
+}
+
+TEST_F(SolverSubtreeTest, LastVariable) {
+    // z is not constrained: its values are enumerated without backtracking
+    std::set<std::pair<unsigned, unsigned>> solutions;
+    sub.activate();
+    while(sub.search()) {
+        ASSERT_TRUE(y.bound());
+        ASSERT_TRUE(z.bound());
+        EXPECT_EQ(y.value(), x.value());
+        solutions.emplace(y.value(), z.value());
+    }
+    EXPECT_EQ(8u, solutions.size());
+    EXPECT_EQ(4u, z.size());
+    EXPECT_GE(3u, solver.statBacktracks());
+}
+
+TEST_F(SolverSubtreeTest, Constraints) {
+    Constraint* c = solver.make<CopyConstraint>(&solver, &z, &y);
+    sub.add(c);
+    std::vector<Constraint*> cstrs = sub.constraints();
+    ASSERT_EQ(2u, cstrs.size());
+    EXPECT_EQ(c, cstrs[1]);
+}
+
+TEST_F(SolverSubtreeTest, Profiling) {
+    countSolutions();
+    EXPECT_TRUE(solver.profiled().empty());
+    solver.profiling(true);
+    countSolutions();
+    solver.profiling(false);
+    ASSERT_EQ(1u, solver.profiled().size());
+    Constraint* c = solver.profiled()[0];
+    EXPECT_LT(0u, c->statCalls());
+    unsigned long calls = c->statCalls();
+    countSolutions();
+    EXPECT_EQ(calls, c->statCalls());
+    solver.profiling(true);
+    EXPECT_EQ(0u, c->statCalls());
+    EXPECT_TRUE(solver.profiled().empty());
+}
+
+TEST_F(SolverSubtreeTest, Budget) {
+    castor::Budget budget;
+    budget.limitBacktracks(1);
+    solver.budget(&budget);
+    sub.activate();
+    EXPECT_THROW({ while(sub.search()); }, castor::BudgetExceeded);
+    // the aborted search can be discarded and started again
+    sub.discard();
+    EXPECT_FALSE(sub.isActive());
+    EXPECT_EQ(3u, x.size());
+    EXPECT_EQ(2u, y.size());
+    budget.clear();
+    EXPECT_EQ(8u, countSolutions());
+    budget.cancel();
+    sub.activate();
+    EXPECT_THROW({ while(sub.search()); }, castor::BudgetExceeded);
+    sub.discard();
+    solver.budget(nullptr);
+}
+
+TEST_F(SolverSubtreeTest, BudgetScope) {
+    castor::Budget exhausted;
+    exhausted.limitBacktracks(0);
+    try {
+        castor::BudgetScope<Solver> scope(solver, &exhausted);
+        EXPECT_EQ(&exhausted, solver.budget());
+        sub.activate();
+        while(sub.search());
+        FAIL() << "search should have been aborted";
+    } catch(const castor::BudgetExceeded&) {
+        sub.discard();
+    }
+    // the exhausted budget is not charged by the next searches
+    EXPECT_EQ(nullptr, solver.budget());
+    EXPECT_EQ(8u, countSolutions());
+    castor::Budget fresh;
+    {
+        castor::BudgetScope<Solver> scope(solver, &fresh);
+        EXPECT_EQ(8u, countSolutions());
+    }
+    EXPECT_EQ(nullptr, solver.budget());
+}
@@ -0,0 +1,130 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "solver/trail.h"
+#include "solver/reversible.h"
+#include "gtest/gtest.h"
+
+using namespace castor::cp;
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixture
+
+/**
+ * Trailable object saved through the virtual save() and restore().
+ */
+class Counter : public Trailable {
+public:
+    Counter(Trail& trail) : Trailable(trail), value(0) {}
+    void save(Trail& trail) const override { trail.push(value); }
+    void restore(Trail& trail) override { value = trail.pop<long>(); }
+    void set(long v) { modifying(); value = v; }
+    long value;
+};
+
+/**
+ * Trailable object saved as typed slots.
+ */
+class Pair : public Trailable {
+public:
+    Pair(Trail& trail) : Trailable(trail), a(0), b(0) {}
+    void save(Trail& trail) const override {}
+    void restore(Trail& trail) override {}
+    void set(int va, char vb) { modifying(&a, &b); a = va; b = vb; }
+    int a;
+    char b;
+};
+
+/**
+ * Count restore notifications.
+ */
+class Listener : public TrailListener {
+public:
+    Listener() : count(0) {}
+    void restored(Trailable*) override { ++count; }
+    unsigned count;
+};
+
+class SolverTrailTest : public ::testing::Test {
+protected:
+    Trail trail;
+
+    SolverTrailTest() : trail(64) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Tests
+
+/**
+ * Restoring should cross chunk boundaries, with entries of different sizes
+ */
+TEST_F(SolverTrailTest, Chunks) {
+    Counter c(trail);
+    Pair p(trail);
+    Reversible<bool> r(trail, false);
+    std::vector<Trail::checkpoint_t> chkps;
+    for(int i = 1; i <= 50; i++) {
+        chkps.push_back(trail.checkpoint());
+        c.set(i);
+        p.set(i, i % 7);
+        r = (i % 2 == 0);
+    }
+    for(int i = 50; i >= 1; i--) {
+        EXPECT_EQ(i, c.value);
+        EXPECT_EQ(i, p.a);
+        EXPECT_EQ(i % 7, p.b);
+        EXPECT_EQ(i % 2 == 0, r);
+        trail.restore(chkps[i-1]);
+    }
+    EXPECT_EQ(0, c.value);
+    EXPECT_EQ(0, p.a);
+    EXPECT_EQ(0, p.b);
+    EXPECT_FALSE(r);
+}
+
+/**
+ * Objects are saved once between two checkpoints
+ */
+TEST_F(SolverTrailTest, SaveOnce) {
+    Pair p(trail);
+    Trail::checkpoint_t chkp = trail.checkpoint();
+    p.set(1, 1);
+    p.set(2, 2);
+    trail.restore(chkp);
+    EXPECT_EQ(0, p.a);
+    p.set(3, 3);
+    trail.restore(chkp);
+    EXPECT_EQ(0, p.a);
+}
+
+/**
+ * Listeners are notified once restore is done
+ */
+TEST_F(SolverTrailTest, Listeners) {
+    Counter c(trail);
+    Pair p(trail);
+    Listener l;
+    c.registerRestored(&l);
+    p.registerRestored(&l);
+    Trail::checkpoint_t chkp = trail.checkpoint();
+    c.set(1);
+    p.set(1, 1);
+    trail.restore(chkp);
+    EXPECT_EQ(2u, l.count);
+    trail.restore(chkp);
+    EXPECT_EQ(2u, l.count);
+}
@@ -20,6 +20,7 @@
 #include <fstream>
 #include "store.h"
 #include "query.h"
+#include <unistd.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 
@@ -44,13 +45,31 @@ inline void printTime(const char* msg, long time) {
 }
 
 int main(int argc, char* argv[]) {
-    if(argc < 3 || argc > 4) {
-        cout << "Usage: " << argv[0] << " DB QUERY [SOL]" << endl;
+    const char* progname = argv[0];
+    bool profile = false;
+    int explain = 0; // 1 = explain, 2 = explain analyze
+    int c;
+    while((c = getopt(argc, argv, "pea")) != -1) {
+        switch(c) {
+        case 'p': profile = true; break;
+        case 'e': explain = 1;    break;
+        case 'a': explain = 2;    break;
+        default:  argc = 0; // print usage
+        }
+    }
+    argc -= optind;
+    argv += optind - 1;
+    if(argc < 2 || argc > 3) {
+        cout << "Usage: " << progname << " [-p|-e|-a] DB QUERY [SOL]" << endl;
+        cout << "  -p  Print the profile of the search as JSON" << endl;
+        cout << "  -e  Print the execution plan instead of searching" << endl;
+        cout << "  -a  Search and print the execution plan with statistics"
+             << endl;
         return 1;
     }
     char* dbpath = argv[1];
     char* rqpath = argv[2];
-    char* solpath = argc > 3 ? argv[3] : nullptr;
+    char* solpath = argc > 2 ? argv[3] : nullptr;
 
 #if CASTOR_SEARCH == CASTOR_SEARCH_random
     srand(time(nullptr));
@@ -85,6 +104,14 @@ int main(int argc, char* argv[]) {
     getrusage(RUSAGE_SELF, &ru[2]);
     printTime("Query init", diffTime(ru[1], ru[2]));
 
+    if(explain) {
+        query.explain(cout, explain == 2);
+        return 0;
+    }
+
+    if(profile)
+        query.profile(true);
+
     while(query.next()) {
         if(query.requested() == 0) {
             *fsol << "YES" << endl;
@@ -94,7 +121,7 @@ int main(int argc, char* argv[]) {
                 if(id == 0) {
                     *fsol << " ";
                 } else {
-                    *fsol << store.lookupValue(id).ensureDirectStrings(store)
+                    *fsol << query.lookupValue(id).ensureDirectStrings(store)
                           << " ";
                 }
             }
@@ -125,14 +152,14 @@ int main(int argc, char* argv[]) {
 
     cout << "Cache hit: " << store.statTripleCacheHits() << endl;
     cout << "Cache miss: " << store.statTripleCacheMisses() << endl;
+    cout << "Resolve cache hit: " << store.statResolveCacheHits() << endl;
+    cout << "Resolve cache miss: " << store.statResolveCacheMisses() << endl;
 
-#ifdef CASTOR_CSTR_TIMING
-    cout << "Constraints:" << endl;
-    for(const auto& item : query.solver()->statCstrCount()) {
-        cout << "  " << item.first.name() << ": " << item.second << " ("
-             << query.solver()->statCstrTime().at(item.first) << "ms)" << endl;
+    if(profile) {
+        cout << "Profile: ";
+        query.writeProfile(cout);
+        cout << endl;
     }
-#endif
 
     return 0;
 }
@@ -20,19 +20,23 @@
 
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <mutex>
 
 #include <unistd.h>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 #include <csignal>
 
 #if CASTOR_SEARCH == CASTOR_SEARCH_random
-#include <cstdlib>
 #include <ctime>
 #endif
 
 #include "store.h"
 #include "query.h"
+#include "querycache.h"
+#include "metrics.h"
 
 using namespace std;
 using namespace castor;
@@ -45,7 +49,11 @@ namespace {
 static const char* DEFAULT_PORT = "8000";
 static const char* PATH = "/sparql";
 static const char* HOMEPATH = "/";
+static const char* METRICSPATH = "/metrics";
+static const char* DEFAULT_THREADS = "4";
+static const unsigned long DEFAULT_TIMEOUT = 0;
 static const unsigned DEFAULT_CACHE = 100;
+static const unsigned DEFAULT_QUERY_CACHE = 256;
 
 static constexpr size_t MAX_QUERY_LEN = 32768;
 static constexpr size_t MAX_POST_LEN = MAX_QUERY_LEN * 2;
@@ -56,6 +64,14 @@ static constexpr size_t MAX_POST_LEN = MAX_QUERY_LEN * 2;
 static const char* progname;
 static bool verbose;
 static const char* mimetype = "application/sparql-results+xml";
+static QueryCache* queries;
+static Metrics* metrics;
+/**
+ * Lock serializing the execution of queries: the store and the prepared
+ * queries are not thread-safe. Other requests are served concurrently.
+ */
+static std::mutex queryLock;
+static unsigned long timeout; //!< default time limit of a query in ms
 
 ////////////////////////////////////////////////////////////////////////////////
 // HTTP handler
@@ -99,6 +115,52 @@ static void escape_xml(mg_connection* conn, const char* str) {
     }
 }
 
+/**
+ * Read a numeric parameter of the request.
+ *
+ * @return the value of the parameter or 0 if absent or invalid
+ */
+static unsigned long get_number(const char* vars, int len, const char* name) {
+    char buf[24];
+    if(mg_get_var(vars, len, name, buf, sizeof(buf)) <= 0)
+        return 0;
+    return strtoul(buf, nullptr, 10);
+}
+
+/**
+ * Set the budget of a query from the parameters of the request.
+ */
+static void set_budget(Query& query, const char* vars, int len) {
+    Budget& budget = query.budget();
+    budget.clear();
+    unsigned long ms = get_number(vars, len, "timeout");
+    if(ms == 0 || (timeout > 0 && ms > timeout))
+        ms = timeout;
+    if(ms > 0)
+        budget.limitTime(ms * 1000000ULL);
+    if(unsigned long n = get_number(vars, len, "max_backtracks"))
+        budget.limitBacktracks(n);
+    if(unsigned long n = get_number(vars, len, "max_triples"))
+        budget.limitTriples(n);
+}
+
+/**
+ * Find the next solution of a query, stopping if its budget is exceeded.
+ *
+ * @param query the query
+ * @param[out] aborted set to the reason if the query has been aborted
+ * @return false if there are no more solutions or the query has been
+ *         aborted, true otherwise
+ */
+static bool next_solution(Query& query, std::string& aborted) {
+    try {
+        return query.next();
+    } catch(const BudgetExceeded& e) {
+        aborted = e.what();
+        return false;
+    }
+}
+
 static int handler(mg_connection* conn) {
     const mg_request_info* req = mg_get_request_info(conn);
     Store* store = reinterpret_cast<Store*>(req->user_data);
@@ -124,28 +186,81 @@ static int handler(mg_connection* conn) {
         return 1;
     }
 
+    if(strcmp(req->uri, METRICSPATH) == 0 &&
+            strcmp(req->request_method, "GET") == 0) {
+        std::ostringstream out;
+        metrics->write(out);
+        start_response(conn, "text/plain; version=0.0.4");
+        mg_write(conn, out.str().c_str(), out.str().size());
+        return 1;
+    }
+
     if(strcmp(req->uri, PATH) != 0)
         return send_error(conn, 404, "Not found.");
 
     char querystr[MAX_QUERY_LEN];
-    int ret;
+    char data[MAX_POST_LEN];
+    const char* vars;
+    int len;
     if(strcmp(req->request_method, "GET") == 0) {
-        ret = mg_get_var(req->query_string, strlen(req->query_string), "query",
-                         querystr, sizeof(querystr));
+        vars = req->query_string == nullptr ? "" : req->query_string;
+        len = strlen(vars);
     } else if(strcmp(req->request_method, "POST") == 0) {
-        char data[MAX_POST_LEN];
-        int len = mg_read(conn, data, sizeof(data));
-        ret = mg_get_var(data, len, "query", querystr, sizeof(querystr));
+        vars = data;
+        len = mg_read(conn, data, sizeof(data));
     } else {
         return send_error(conn, 405, "Unsupported method.");
     }
+    int ret = mg_get_var(vars, len, "query", querystr, sizeof(querystr));
     if(ret == -1)
         return send_error(conn, 400, "Need to specify query.");
     else if(ret == -2)
         return send_error(conn, 500, "Query too long.");
-
+    char profile[2];
+    bool profiling = mg_get_var(vars, len, "profile",
+                                profile, sizeof(profile)) == 1 &&
+                     profile[0] == '1';
+    char explain[8];
+    if(mg_get_var(vars, len, "explain", explain, sizeof(explain)) < 0)
+        explain[0] = '\0';
+
+    metrics->enqueue();
+    std::lock_guard<std::mutex> lock(queryLock);
+    Metrics::Execution execution(*metrics);
     try {
-        Query query(store, querystr);
+        Query& query = *queries->get(querystr);
+        metrics->queryCache(queries->statHits(), queries->statMisses());
+        execution.query(&query);
+        set_budget(query, vars, len);
+        if(strcmp(explain, "1") == 0 || strcmp(explain, "analyze") == 0) {
+            // show the execution plan instead of the results
+            std::ostringstream out;
+            query.explain(out, explain[0] == 'a');
+            start_response(conn, "text/plain");
+            mg_write(conn, out.str().c_str(), out.str().size());
+            if(verbose)
+                cout << "--" << endl << querystr << endl << "--" << endl
+                     << out.str();
+            return 1;
+        }
+        if(profiling) {
+            // run the whole query and only report its profile
+            query.profile(true);
+            while(query.next());
+            std::ostringstream out;
+            query.writeProfile(out);
+            query.profile(false);
+            start_response(conn, "application/json");
+            mg_write(conn, out.str().c_str(), out.str().size());
+            if(verbose)
+                cout << "--" << endl << querystr << endl << "--" << endl
+                     << out.str() << endl;
+            return 1;
+        }
+        // find the first solution before answering: a query aborted by then
+        // still gets an error status
+        bool more = query.next();
+        std::string aborted;
         start_response(conn, mimetype);
         if(verbose)
             cout << "--" << endl << querystr << endl << "--" << endl;
@@ -160,14 +275,13 @@ static int handler(mg_connection* conn) {
         }
         mg_printf(conn, "  </head>\n");
         if(query.requested() == 0) {
-            query.next();
             mg_printf(conn, "  <boolean>%s</boolean>\n",
-                      query.count() == 0 ? "false" : "true");
+                      more ? "true" : "false");
         } else {
             mg_printf(conn, "  <results distinct=\"%s\" ordered=\"%s\">\n",
                       query.isDistinct() ? "true" : "false",
                       query.orders().empty() ? "false" : "true");
-            while(query.next()) {
+            for(; more; more = next_solution(query, aborted)) {
                 mg_printf(conn, "    <result>\n");
                 for(unsigned i = 0; i < query.requested(); ++i) {
                     Variable* var = query.variable(i);
@@ -176,7 +290,7 @@ static int handler(mg_connection* conn) {
                         mg_printf(conn, "      <binding name=\"");
                         escape_xml(conn, var->name().c_str());
                         mg_printf(conn, "\">");
-                        Value val = store->lookupValue(id);
+                        Value val = query.lookupValue(id);
                         val.ensureDirectStrings(*store);
                         switch(val.category()) {
                         case Value::CAT_BLANK:
@@ -213,6 +327,11 @@ static int handler(mg_connection* conn) {
                 }
                 mg_printf(conn, "    </result>\n");
             }
+            if(!aborted.empty()) {
+                mg_printf(conn, "    <!-- ");
+                escape_xml(conn, aborted.c_str());
+                mg_printf(conn, " -->\n");
+            }
             mg_printf(conn, "  </results>\n");
         }
         mg_printf(conn, "</sparql>");
@@ -224,16 +343,24 @@ static int handler(mg_connection* conn) {
             cout << "  Propagate: " << query.solver()->statPropagate() << endl;
             cout << "  Cache hit: " << store->statTripleCacheHits() << endl;
             cout << "  Cache miss: " << store->statTripleCacheMisses() << endl;
-#ifdef CASTOR_CSTR_TIMING
-            cout << "  Constraints:" << endl;
-            for(const auto& item : query.solver()->statCstrCount()) {
-                cout << "    " << item.first.name() << ": " << item.second
-                     << " (" << query.solver()->statCstrTime().at(item.first)
-                     << "ms)" << endl;
-            }
-#endif
+            cout << "  Resolve cache hit: " << store->statResolveCacheHits() << endl;
+            cout << "  Resolve cache miss: " << store->statResolveCacheMisses() << endl;
+            cout << "  Query cache hit: " << queries->statHits() << endl;
+            cout << "  Query cache miss: " << queries->statMisses() << endl;
+        }
+        if(!aborted.empty()) {
+            if(verbose)
+                cout << "  " << aborted << endl;
+            execution.abort();
+            queries->evict(querystr);
         }
-    } catch(CastorException e) {
+    } catch(const BudgetExceeded& e) {
+        // the search has been interrupted: do not reuse the query
+        execution.abort();
+        queries->evict(querystr);
+        return send_error(conn, 503, e.what());
+    } catch(const CastorException& e) {
+        execution.fail();
         return send_error(conn, 400, e.what());
     }
     return 1;
@@ -248,6 +375,9 @@ static void usage() {
     cout << "  -d DB         Dataset to load" << endl;
     cout << "  -p PORT       Port to listen on (default: " << DEFAULT_PORT << ")" << endl;
     cout << "  -c CAPACITY   Triple cache capacity (default: " << DEFAULT_CACHE << ")" << endl;
+    cout << "  -q CAPACITY   Prepared queries cache capacity (default: " << DEFAULT_QUERY_CACHE << ")" << endl;
+    cout << "  -t THREADS    Number of worker threads (default: " << DEFAULT_THREADS << ")" << endl;
+    cout << "  -T TIMEOUT    Maximum time of a query in ms, 0 for none (default: " << DEFAULT_TIMEOUT << ")" << endl;
     cout << "  -x            Use application/xml content type for results." << endl;
     cout << "  -v            Be verbose" << endl;
     exit(1);
@@ -261,12 +391,18 @@ int main(int argc, char* argv[]) {
     char* dbpath = nullptr;
     const char* port = DEFAULT_PORT;
     unsigned cache = DEFAULT_CACHE;
+    unsigned queryCache = DEFAULT_QUERY_CACHE;
+    const char* threads = DEFAULT_THREADS;
+    timeout = DEFAULT_TIMEOUT;
     verbose = false;
-    while((c = getopt(argc, argv, "d:p:c:xv")) != -1) {
+    while((c = getopt(argc, argv, "d:p:c:q:t:T:xv")) != -1) {
         switch(c) {
         case 'd': dbpath = optarg;                   break;
         case 'p': port = optarg;                     break;
         case 'c': cache = atoi(optarg);              break;
+        case 'q': queryCache = atoi(optarg);         break;
+        case 't': threads = optarg;                  break;
+        case 'T': timeout = strtoul(optarg, nullptr, 10); break;
         case 'x': mimetype = "application/xml";      break;
         case 'v': verbose = true;                    break;
         default: usage();
@@ -283,6 +419,10 @@ int main(int argc, char* argv[]) {
     if(verbose)
         cout << "Loading " << dbpath << "." << endl;
     Store store(dbpath, cache);
+    QueryCache prepared(&store, queryCache);
+    queries = &prepared;
+    Metrics serverMetrics(&store);
+    metrics = &serverMetrics;
 
     // Start HTTP server
     mg_callbacks callbacks;
@@ -290,7 +430,7 @@ int main(int argc, char* argv[]) {
     callbacks.begin_request = handler;
 
     const char* options[] = {"listening_ports", port,
-                             "num_threads", "1",
+                             "num_threads", threads,
                              nullptr};
 
     mg_context* ctx = mg_start(&callbacks, &store, options);
@@ -0,0 +1,214 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "metrics.h"
+
+#include "util.h"
+
+namespace castor {
+
+const double Metrics::BUCKET_BOUNDS[BUCKETS] = {
+    0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 60
+};
+
+Metrics::Metrics(Store* store) : store_(store) {
+    waiting_ = 0;
+    inFlight_ = 0;
+    queries_ = 0;
+    errors_ = 0;
+    aborted_ = 0;
+    for(Counter& bucket : buckets_)
+        bucket = 0;
+    latency_ = 0;
+    backtracks_ = 0;
+    subtrees_ = 0;
+    post_ = 0;
+    propagate_ = 0;
+    queryCacheHits_ = 0;
+    queryCacheMisses_ = 0;
+    publish();
+}
+
+void Metrics::publish() {
+    auto set = [](Counter& counter, unsigned long value) {
+        counter.store(value, std::memory_order_relaxed);
+    };
+    set(tripleRanges_, store_->statTripleRanges());
+    set(triplesScanned_, store_->statTriplesScanned());
+    set(pagesRead_, store_->statPagesRead());
+    set(cacheHits_, store_->statTripleCacheHits());
+    set(cacheMisses_, store_->statTripleCacheMisses());
+    set(cacheEvictions_, store_->statTripleCacheEvictions());
+    set(cacheSize_, store_->statTripleCacheSize());
+    set(cacheCapacity_, store_->statTripleCacheCapacity());
+}
+
+Metrics::Execution::Execution(Metrics& metrics) :
+        metrics_(metrics), query_(nullptr), failed_(false), aborted_(false),
+        start_(monotonicTime()) {
+    metrics_.waiting_.fetch_sub(1, std::memory_order_relaxed);
+    metrics_.inFlight_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::Execution::query(Query* query) {
+    query_ = query;
+    cp::Solver* solver = query->solver();
+    backtracks_ = solver->statBacktracks();
+    subtrees_ = solver->statSubtrees();
+    post_ = solver->statPost();
+    propagate_ = solver->statPropagate();
+}
+
+void Metrics::Execution::fail() {
+    account();
+    failed_ = true;
+}
+
+void Metrics::Execution::account() {
+    if(query_ == nullptr)
+        return;
+    cp::Solver* solver = query_->solver();
+    metrics_.backtracks_.fetch_add(solver->statBacktracks() - backtracks_,
+                                   std::memory_order_relaxed);
+    metrics_.subtrees_.fetch_add(solver->statSubtrees() - subtrees_,
+                                 std::memory_order_relaxed);
+    metrics_.post_.fetch_add(solver->statPost() - post_,
+                             std::memory_order_relaxed);
+    metrics_.propagate_.fetch_add(solver->statPropagate() - propagate_,
+                                  std::memory_order_relaxed);
+    query_ = nullptr;
+}
+
+Metrics::Execution::~Execution() {
+    account();
+    unsigned long long time = monotonicTime() - start_;
+    unsigned bucket = 0;
+    while(bucket < BUCKETS && time > BUCKET_BOUNDS[bucket] * 1e9)
+        ++bucket;
+    if(bucket < BUCKETS)
+        metrics_.buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    metrics_.latency_.fetch_add(time, std::memory_order_relaxed);
+    metrics_.publish();
+    if(failed_)
+        metrics_.errors_.fetch_add(1, std::memory_order_relaxed);
+    if(aborted_)
+        metrics_.aborted_.fetch_add(1, std::memory_order_relaxed);
+    metrics_.queries_.fetch_add(1, std::memory_order_relaxed);
+    metrics_.inFlight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+namespace {
+
+/**
+ * Write the header of a metric.
+ */
+void header(std::ostream& out, const char* name, const char* type,
+            const char* help) {
+    out << "# HELP " << name << ' ' << help << '\n'
+        << "# TYPE " << name << ' ' << type << '\n';
+}
+
+/**
+ * Write a metric with a single value.
+ */
+void metric(std::ostream& out, const char* name, const char* type,
+            const char* help, unsigned long value) {
+    header(out, name, type, help);
+    out << name << ' ' << value << '\n';
+}
+
+}
+
+void Metrics::write(std::ostream& out) const {
+    auto get = [](const Counter& counter) {
+        return counter.load(std::memory_order_relaxed);
+    };
+
+    // read the total first: the buckets are never behind it
+    unsigned long count = get(queries_);
+    double sum = latency_.load(std::memory_order_relaxed) / 1e9;
+    header(out, "castord_query_duration_seconds", "histogram",
+           "Time to execute a query.");
+    unsigned long cumulative = 0;
+    for(unsigned i = 0; i < BUCKETS; i++) {
+        cumulative += get(buckets_[i]);
+        out << "castord_query_duration_seconds_bucket{le=\""
+            << BUCKET_BOUNDS[i] << "\"} " << cumulative << '\n';
+    }
+    if(cumulative > count)
+        count = cumulative;
+    out << "castord_query_duration_seconds_bucket{le=\"+Inf\"} " << count
+        << '\n'
+        << "castord_query_duration_seconds_sum " << sum << '\n'
+        << "castord_query_duration_seconds_count " << count << '\n';
+
+    metric(out, "castord_query_errors_total", "counter",
+           "Queries that failed.", get(errors_));
+    metric(out, "castord_queries_aborted_total", "counter",
+           "Queries aborted because they exceeded their budget.",
+           get(aborted_));
+    metric(out, "castord_queries_waiting", "gauge",
+           "Queries waiting to be executed.", get(waiting_));
+    metric(out, "castord_queries_in_flight", "gauge",
+           "Queries being executed.", get(inFlight_));
+
+    metric(out, "castord_solver_backtracks_total", "counter",
+           "Backtracks of the solvers.", get(backtracks_));
+    metric(out, "castord_solver_subtrees_total", "counter",
+           "Subtrees searched by the solvers.", get(subtrees_));
+    metric(out, "castord_solver_post_total", "counter",
+           "Calls to the post methods of constraints.", get(post_));
+    metric(out, "castord_solver_propagate_total", "counter",
+           "Calls to the propagate methods of constraints.",
+           get(propagate_));
+
+    metric(out, "castord_store_triple_ranges_total", "counter",
+           "Ranges of triples queried.", get(tripleRanges_));
+    metric(out, "castord_store_triples_scanned_total", "counter",
+           "Triples returned by triple ranges.", get(triplesScanned_));
+    metric(out, "castord_store_pages_read_total", "counter",
+           "Pages read by triple ranges.", get(pagesRead_));
+    metric(out, "castord_triple_cache_hits_total", "counter",
+           "Triple cache hits.", get(cacheHits_));
+    metric(out, "castord_triple_cache_misses_total", "counter",
+           "Triple cache misses.", get(cacheMisses_));
+    metric(out, "castord_triple_cache_evictions_total", "counter",
+           "Triple cache lines evicted.", get(cacheEvictions_));
+    metric(out, "castord_triple_cache_lines", "gauge",
+           "Triple cache lines in use.", get(cacheSize_));
+    metric(out, "castord_triple_cache_capacity_lines", "gauge",
+           "Triple cache lines allocated.", get(cacheCapacity_));
+    unsigned long hits = get(cacheHits_);
+    unsigned long lookups = hits + get(cacheMisses_);
+    header(out, "castord_triple_cache_hit_ratio", "gauge",
+           "Ratio of triple cache lookups that hit.");
+    out << "castord_triple_cache_hit_ratio "
+        << (lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups) << '\n';
+    metric(out, "castord_query_cache_hits_total", "counter",
+           "Prepared query cache hits.", get(queryCacheHits_));
+    metric(out, "castord_query_cache_misses_total", "counter",
+           "Prepared query cache misses.", get(queryCacheMisses_));
+
+    // mincore() only reads the page tables: safe while queries run
+    metric(out, "castord_store_file_bytes", "gauge",
+           "Size of the store file.", store_->statFileSize());
+    metric(out, "castord_store_resident_bytes", "gauge",
+           "Bytes of the store file resident in memory.",
+           store_->statResidentSize());
+}
+
+}
@@ -0,0 +1,172 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CASTORD_METRICS_H
+#define CASTORD_METRICS_H
+
+#include <atomic>
+#include <iostream>
+
+#include "store.h"
+#include "query.h"
+
+namespace castor {
+
+/**
+ * Runtime metrics of the server, exported in the Prometheus text format.
+ * All counters are atomic: they may be read by any worker while a query is
+ * being executed. The statistics of the store and the solvers are only
+ * accessed by the worker executing queries and are published in these
+ * counters after each query.
+ */
+class Metrics {
+public:
+    /**
+     * Upper bounds of the buckets of the latency histogram, in seconds.
+     */
+    static constexpr unsigned BUCKETS = 10;
+    static const double BUCKET_BOUNDS[BUCKETS];
+
+    /**
+     * Tracks the execution of a query. The query is counted as in flight
+     * during the lifetime of this object.
+     */
+    class Execution {
+    public:
+        /**
+         * Start executing a query that has been enqueued with enqueue().
+         *
+         * @param metrics the metrics to update
+         */
+        Execution(Metrics& metrics);
+        /**
+         * Record the end of the execution.
+         */
+        ~Execution();
+
+        //! Non-copyable
+        Execution(const Execution&) = delete;
+        Execution& operator=(const Execution&) = delete;
+
+        /**
+         * Set the query being executed, to account for the work of its
+         * solver.
+         *
+         * @param query the query
+         */
+        void query(Query* query);
+
+        /**
+         * Mark the execution as failed. The query set with query() may be
+         * deleted afterwards.
+         */
+        void fail();
+
+        /**
+         * Mark the execution as aborted because it exceeded its budget. The
+         * query set with query() may be deleted afterwards.
+         */
+        void abort() { fail(); aborted_ = true; }
+
+    private:
+        /**
+         * Add the work of the solver of the query to the counters.
+         */
+        void account();
+
+        Metrics& metrics_;
+        Query*   query_;
+        bool     failed_;
+        bool     aborted_;
+        unsigned long long start_; //!< start time in nanoseconds
+        unsigned long backtracks_;
+        unsigned long subtrees_;
+        unsigned long post_;
+        unsigned long propagate_;
+    };
+
+    /**
+     * @param store the store to report about
+     */
+    Metrics(Store* store);
+
+    //! Non-copyable
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    /**
+     * A query is waiting to be executed.
+     */
+    void enqueue() { waiting_.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * Publish the statistics of a query cache.
+     *
+     * @param hits number of cache hits
+     * @param misses number of cache misses
+     */
+    void queryCache(unsigned long hits, unsigned long misses) {
+        queryCacheHits_.store(hits, std::memory_order_relaxed);
+        queryCacheMisses_.store(misses, std::memory_order_relaxed);
+    }
+
+    /**
+     * Write the metrics in the Prometheus text exposition format.
+     *
+     * @param out output stream
+     */
+    void write(std::ostream& out) const;
+
+private:
+    /**
+     * Publish the statistics of the store.
+     */
+    void publish();
+
+    typedef std::atomic<unsigned long> Counter;
+
+    Store* store_;
+
+    Counter waiting_;  //!< queries waiting to be executed
+    Counter inFlight_; //!< queries being executed
+    Counter queries_;  //!< executed queries
+    Counter errors_;   //!< failed queries
+    Counter aborted_;  //!< queries aborted by their budget
+
+    Counter buckets_[BUCKETS]; //!< non-cumulative latency histogram
+    std::atomic<unsigned long long> latency_; //!< total latency (ns)
+
+    Counter backtracks_;
+    Counter subtrees_;
+    Counter post_;
+    Counter propagate_;
+
+    Counter tripleRanges_;
+    Counter triplesScanned_;
+    Counter pagesRead_;
+    Counter cacheHits_;
+    Counter cacheMisses_;
+    Counter cacheEvictions_;
+    Counter cacheSize_;
+    Counter cacheCapacity_;
+    Counter queryCacheHits_;
+    Counter queryCacheMisses_;
+};
+
+}
+
+#endif // CASTORD_METRICS_H
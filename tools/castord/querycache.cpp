@@ -0,0 +1,138 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "querycache.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace castor {
+
+/**
+ * Characters that cannot appear in an IRI reference, besides control
+ * characters and space (see the IRIREF rule of the SPARQL grammar).
+ */
+static const char IRI_EXCLUDED[] = "<\"{}|^`\\";
+
+QueryCache::QueryCache(Store* store, unsigned capacity) :
+        store_(store), capacity_(capacity), statHits_(0), statMisses_(0) {}
+
+QueryCache::~QueryCache() {
+    for(auto& entry : queries_)
+        delete entry.second;
+}
+
+Query* QueryCache::get(const char* queryString) {
+    std::string key = normalize(queryString);
+    auto it = index_.find(key);
+    if(it != index_.end()) {
+        ++statHits_;
+        queries_.splice(queries_.begin(), queries_, it->second);
+        Query* query = queries_.front().second;
+        query->reset();
+        return query;
+    }
+
+    ++statMisses_;
+    Query* query = new Query(store_, key.c_str());
+    queries_.emplace_front(key, query);
+    index_[key] = queries_.begin();
+    while(queries_.size() > capacity_ && queries_.size() > 1) {
+        index_.erase(queries_.back().first);
+        delete queries_.back().second;
+        queries_.pop_back();
+    }
+    return query;
+}
+
+void QueryCache::evict(const char* queryString) {
+    auto it = index_.find(normalize(queryString));
+    if(it == index_.end())
+        return;
+    delete it->second->second;
+    queries_.erase(it->second);
+    index_.erase(it);
+}
+
+std::string QueryCache::normalize(const char* queryString) {
+    std::string result;
+    const char* p = queryString;
+    char space = '\0'; // pending whitespace
+    while(*p) {
+        char c = *p;
+        if(isspace(static_cast<unsigned char>(c))) {
+            // keep line breaks as they end comments
+            if(space != '\n')
+                space = (c == '\n' || c == '\r') ? '\n' : ' ';
+            ++p;
+            continue;
+        }
+        if(c == '#') {
+            // comment until the end of the line
+            while(*p && *p != '\n' && *p != '\r')
+                ++p;
+            if(!space)
+                space = ' ';
+            continue;
+        }
+        if(space && !result.empty())
+            result += space;
+        space = '\0';
+
+        if(c == '"' || c == '\'') {
+            // string literal, possibly long
+            const char quote[4] = {c, c, c, '\0'};
+            size_t delim = strncmp(p, quote, 3) == 0 ? 3 : 1;
+            result.append(p, delim);
+            p += delim;
+            while(*p && strncmp(p, quote, delim) != 0) {
+                if(*p == '\\' && p[1])
+                    result += *p++;
+                result += *p++;
+            }
+            size_t len = strnlen(p, delim);
+            result.append(p, len);
+            p += len;
+        } else if(c == '<') {
+            // IRI reference or less-than operator
+            const char* end = p + 1;
+            bool quote = false;
+            while(static_cast<unsigned char>(*end) > ' ' && *end != '>' &&
+                  !strchr(IRI_EXCLUDED, *end)) {
+                quote |= *end == '\'';
+                ++end;
+            }
+            if(*end != '>') {
+                result += *p++;
+            } else if(quote) {
+                // either an IRI or a comparison with a string literal:
+                // keep the rest of the query untouched
+                result.append(p);
+                break;
+            } else {
+                end++;
+                result.append(p, end - p);
+                p = end;
+            }
+        } else {
+            result += *p++;
+        }
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,95 @@
+/* This file is part of Castor
+ *
+ * Author: Vianney le Clément de Saint-Marcq <vianney.leclement@uclouvain.be>
+ * Copyright (C) 2010-2013, Université catholique de Louvain
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CASTORD_QUERYCACHE_H
+#define CASTORD_QUERYCACHE_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "store.h"
+#include "query.h"
+
+namespace castor {
+
+/**
+ * LRU cache of prepared queries. A prepared query has been parsed, resolved
+ * against the store and optimized. Executing it again only requires resetting
+ * the search.
+ */
+class QueryCache {
+public:
+    /**
+     * @param store the store to query
+     * @param capacity maximum number of prepared queries (at least the last
+     *                 returned query is always kept)
+     */
+    QueryCache(Store* store, unsigned capacity);
+    ~QueryCache();
+
+    //! Non-copyable
+    QueryCache(const QueryCache&) = delete;
+    QueryCache& operator=(const QueryCache&) = delete;
+
+    /**
+     * Get a query ready to be executed. The query remains owned by the cache
+     * and stays valid until the next call to get().
+     *
+     * @param queryString SPARQL query
+     * @return the prepared query
+     * @throws CastorException on parse error
+     */
+    Query* get(const char* queryString);
+
+    /**
+     * Remove a query from the cache, e.g., because its search has been
+     * aborted. The query is deleted.
+     *
+     * @param queryString SPARQL query
+     */
+    void evict(const char* queryString);
+
+    /**
+     * Normalize a query string: comments are removed and sequences of
+     * whitespace outside literals and IRIs are collapsed into a single space
+     * or line break. As a single quote may appear in an IRI, the rest of the
+     * query is kept untouched after an IRI containing one.
+     *
+     * @param queryString SPARQL query
+     * @return the normalized query string
+     */
+    static std::string normalize(const char* queryString);
+
+    unsigned long statHits() const   { return statHits_; }   //!< @return number of cache hits
+    unsigned long statMisses() const { return statMisses_; } //!< @return number of cache misses
+
+private:
+    typedef std::list<std::pair<std::string, Query*>> List;
+
+    Store* store_;
+    unsigned capacity_;
+    List queries_; //!< prepared queries, most recently used first
+    std::unordered_map<std::string, List::iterator> index_;
+
+    unsigned long statHits_;
+    unsigned long statMisses_;
+};
+
+}
+
+#endif // CASTORD_QUERYCACHE_H
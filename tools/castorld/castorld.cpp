@@ -19,6 +19,7 @@
 #include <fstream>
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <cassert>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -251,12 +252,14 @@ void resolveStringIds(TempFile& rawValues, TempFile& resolvedValues,
  * @param earlyMap will contain the (early id, id) mapping ordered by early id
  * @param hashes will contain (hash, id) pairs ordered by hash
  * @param valueEqClasses will contain the equivalence classes boundaries
+ * @param numbers will contain the native numbers of the numeric values,
+ *                ordered by id
  * @param categories array that will contain the start ids for each category
  *                   (including virtual last class)
  * @param resolver string resolver
  */
 void buildValues(TempFile& rawValues, TempFile& values, TempFile& earlyMap,
-                 TempFile& hashes, TempFile& valueEqClasses,
+                 TempFile& hashes, TempFile& valueEqClasses, TempFile& numbers,
                  Value::id_t* categories, StringMapper& resolver) {
     // sort values using SPARQL order
     // Make numapprox empty, as it has not been initialized yet and would
@@ -310,6 +313,17 @@ void buildValues(TempFile& rawValues, TempFile& values, TempFile& earlyMap,
                     eqBuf = 0;
                     eqShift = 0;
                 }
+                if(val.isNumeric()) {
+                    // Native number, 0 for decimals
+                    long n = 0;
+                    if(val.isInteger()) {
+                        n = val.integer();
+                    } else if(val.isFloating()) {
+                        double d = val.floating();
+                        memcpy(&n, &d, sizeof(n));
+                    }
+                    numbers.writeSignedLong(n);
+                }
                 if(!last.validId() || last.category() != val.category())
                     categories[val.category()] = val.id();
                 last = std::move(val);
@@ -531,6 +545,8 @@ struct StoreBuilder {
         unsigned begin;     //!< first page of table
         unsigned index;     //!< index (hash->id mapping)
         unsigned eqClasses; //!< first page of equivalence classes boundaries
+        unsigned numapprox; //!< first page of numeric approximations table
+        unsigned numbers;   //!< first page of native numbers table
 
         //! first id of each category
         Value::id_t categories[Value::CATEGORIES + 1];
@@ -1046,16 +1062,16 @@ void storeStrings(StoreBuilder& b, TempFile& strings, TempFile& map,
  * @param values file with ordered values. Will be discarded.
  * @param hashes file with (hash, id) pairs ordered by hash. Will be discarded.
  * @param eqClasses value equivalence classes boundaries. Will be discarded.
+ * @param numbers native numbers of the numeric values. Will be discarded.
  */
 void storeValues(StoreBuilder& b, TempFile& values, TempFile& hashes,
-                 TempFile& eqClasses) {
+                 TempFile& eqClasses, TempFile& numbers) {
     // Store table
     b.values.begin = b.w.page();
     {
         MMapFile f(values.fileName().c_str());
         b.w.directWrite(f.begin().get(), f.size());
     }
-    values.discard();
 
     // Store eqClasses
     b.values.eqClasses = b.w.page();
@@ -1065,6 +1081,33 @@ void storeValues(StoreBuilder& b, TempFile& values, TempFile& hashes,
     }
     eqClasses.discard();
 
+    // Store numeric approximations of the numeric values
+    b.values.numapprox = b.w.page();
+    {
+        Value::id_t from = b.values.categories[Value::CAT_NUMERIC];
+        Value::id_t to = b.values.categories[Value::CAT_NUMERIC + 1];
+        if(from < to) {
+            MMapFile f(values.fileName().c_str());
+            Buffer buf((to - from) * 8);
+            for(Value::id_t id = from; id < to; id++) {
+                Cursor cur = f.begin() + (id - 1) * Value::SERIALIZED_SIZE;
+                Value val(cur);
+                buf.writeSignedLong(val.numapprox().lower());
+            }
+            b.w.directWrite(buf.get(), buf.written());
+        }
+    }
+    values.discard();
+
+    // Store native numbers
+    b.values.numbers = b.w.page();
+    if(b.values.categories[Value::CAT_NUMERIC] <
+            b.values.categories[Value::CAT_NUMERIC + 1]) {
+        MMapFile f(numbers.fileName().c_str());
+        b.w.directWrite(f.begin().get(), f.size());
+    }
+    numbers.discard();
+
     // Store hashmap
     const unsigned SUBHEADER_SIZE = 4; // additional header size
     const unsigned ENTRY_SIZE = 8; // size of an entry
@@ -1164,6 +1207,8 @@ void storeHeader(StoreBuilder& b) {
     b.w.writeInt(b.values.begin);
     b.w.writeInt(b.values.index);
     b.w.writeInt(b.values.eqClasses);
+    b.w.writeInt(b.values.numapprox);
+    b.w.writeInt(b.values.numbers);
     for(Value::Category cat = Value::CAT_BLANK; cat <= Value::CATEGORIES; ++cat)
         b.w.writeInt(b.values.categories[cat]);
 
@@ -1255,19 +1300,20 @@ int main(int argc, char* argv[]) {
 
     cout << "Building values..." << endl;
     TempFile values(dbpath), valuesEarlyMap(dbpath), valuesHashes(dbpath),
-             valuesEqClasses(dbpath);
+             valuesEqClasses(dbpath), valuesNumbers(dbpath);
     Value::id_t categories[Value::CATEGORIES + 1];
     {
         MMapFile fStrings(strings.fileName().c_str()),
                  fMap(stringsMap.fileName().c_str());
         StringMapper resolver(fStrings.begin(), fMap.begin());
         buildValues(resolvedValues, values, valuesEarlyMap, valuesHashes,
-                    valuesEqClasses, categories, resolver);
+                    valuesEqClasses, valuesNumbers, categories, resolver);
     }
     values.close();
     valuesEarlyMap.close();
     valuesHashes.close();
     valuesEqClasses.close();
+    valuesNumbers.close();
 
     cout << "Resolving value ids in triples..." << endl;
     TempFile triples(dbpath);
@@ -1287,7 +1333,7 @@ int main(int argc, char* argv[]) {
     storeStrings(b, strings, stringsMap, stringsHashes, stringsCount);
 
     cout << "Storing values..." << endl;
-    storeValues(b, values, valuesHashes, valuesEqClasses);
+    storeValues(b, values, valuesHashes, valuesEqClasses, valuesNumbers);
 
     cout << "Storing header..." << endl;
     storeHeader(b);